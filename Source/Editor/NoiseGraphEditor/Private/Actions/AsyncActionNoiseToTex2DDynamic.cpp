@@ -51,63 +51,62 @@ void UAsyncActionNoiseToTex2DDynamic::Activate() {
 		return;
 	}
 
-	UNoiseGraph::SamplingParameters params;
-	params.Spacing = (1 / UNoiseGraph::Fp(ScaleOverride));
-	params.Add(UNoiseGraph::Fp(OffsetXOverride), Texture->SizeX);
-	params.Add(UNoiseGraph::Fp(OffsetYOverride), Texture->SizeY);
+	Params = UNoiseGraph::SamplingParameters();
+	Params.Spacing = (1 / UNoiseGraph::Fp(ScaleOverride));
+	Params.Add(UNoiseGraph::Fp(OffsetXOverride), Texture->SizeX);
+	Params.Add(UNoiseGraph::Fp(OffsetYOverride), Texture->SizeY);
 
 	if (Use3D) {
-		params.Add(UNoiseGraph::Fp(OffsetZOverride), 1);
+		Params.Add(UNoiseGraph::Fp(OffsetZOverride), 1);
 	}
 
-	Samples = UNoiseGraph::Allocate<TSamples>(params);
-
 	// Optimization - Avoids rebuilding the noise graph unless required due to changes. 
 	// this is to prevent re-allocating many times, allows nodes to "reuse" their allocations. 
 	if (RebuildNoiseGraph) {
 		NoiseGraph->Build();
 	}
 
-	NoiseGraph->Sample<TSamples>(params, Samples);
-
-	/*
-	TSamples min = std::numeric_limits<TSamples>::max();
-	TSamples max = std::numeric_limits<TSamples>::min();
-
-	for (int i = 0; i < params.GetSize(); i++) {
-		if (min > Samples[i]) {
-			min = Samples[i];
-		}
+	// The graph is built and compiled here, on the game thread, since Build() runs blueprint
+	// code. The render command only gets the sampler and the context, not the graph.
+	UNoiseGraph::Sampler sampler = NoiseGraph->GetSampler();
 
-		if (max < Samples[i]) {
-			max = Samples[i];
-		}
+	if (!sampler) {
+		UE_LOG(LogNoiseGraphEditor, Warning,
+			TEXT("Cannot activate UAsyncActionNoiseToTex2DDynamic, the NoiseGraph did not build.")
+		);
+		FailedTask();
+		return;
 	}
-	UE_LOG(LogNoiseGraphEditor, Warning, TEXT("Max: %d   Min: %d"), max, min);
-	*/
 
-	QueueGPUWriteSamplesToTexture();
+	UNoiseGraph::ContextHandle context = NoiseGraph->AcquireContext();
+	sampler->PreProcessGrid(Params, *context);
+
+	QueueGPUWriteSamplesToTexture(sampler, context);
 }
 
-void UAsyncActionNoiseToTex2DDynamic::QueueGPUWriteSamplesToTexture() {
+void UAsyncActionNoiseToTex2DDynamic::QueueGPUWriteSamplesToTexture(
+	UNoiseGraph::Sampler sampler, UNoiseGraph::ContextHandle context
+) {
 	// Used to ensure the gpu finishes the render command before completing the node
 	Fence = RHICreateGPUFence(TEXT("GPUFence"));
 
+	FTexture2DDynamicResource* textureResource =
+		static_cast<FTexture2DDynamicResource*>(Texture->GetResource());
+
 	// Use ENQUEUE_RENDER_COMMAND to ensure RHI calls are made in the correct thread context
 	ENQUEUE_RENDER_COMMAND(WriteToTextureCmd)(
-		[this](
+		[this, sampler, context, textureResource, params = Params](
 			FRHICommandListImmediate& RHICmdList
 			) {
 
 			// Lock the texture to access pixel data
-			FTexture2DDynamicResource* textureResource = 
-				static_cast<FTexture2DDynamicResource*>(Texture->GetResource());
 			FTextureRHIRef textureRHI = textureResource->GetTextureRHI();
 
 			// Ensures RHI is valid. Texture may not always be available. 
 			// If its not valid and lock is attempted, could cause fatal errors. 
 			if (!textureRHI.IsValid()) {
 				UE_LOG(LogNoiseGraphEditor, Error, TEXT("Texture RHI is invalid."));
+				sampler->PostProcess(*context);
 				FailedTask();
 				return;
 			}
@@ -122,28 +121,22 @@ void UAsyncActionNoiseToTex2DDynamic::QueueGPUWriteSamplesToTexture() {
 					GetPixelFormatString(textureRHI->GetFormat())
 				);
 
+				sampler->PostProcess(*context);
 				FailedTask();
 				return;
 			}
 			uint32 destStride;
 			void* textureData = RHILockTexture2D(textureRHI, 0, RLM_WriteOnly, destStride, false);
-			destStride = destStride / sizeof(TSamples);
-
-			int sizeX = Texture->SizeX;
-			int sizeY = Texture->SizeY;
-			TSamples* dest = static_cast<TSamples*>(textureData);
-			TSamples* source = Samples.GetPtr();
-
-			for (int i = 0, y = 0; y < sizeY; y++) {
-				for (int x = 0; x < sizeX; x++) {
-					TSamples* finalDest = dest + (y * destStride) + (x * 4);
-					finalDest[0] = source[i];
-					finalDest[1] = source[i];
-					finalDest[2] = source[i];
-					finalDest[3] = std::numeric_limits<TSamples>::max();
-					++i;
-				}
-			}
+
+			// Samples are written straight into the texture, as grayscale with an opaque alpha.
+			UNoiseGraph::OutputView<TSamples> view = UNoiseGraph::OutputView<TSamples>::Texels(
+				static_cast<TSamples*>(textureData), 4, destStride / sizeof(TSamples));
+			view.Channels = 3;
+			view.HasPad = true;
+			view.Pad = std::numeric_limits<TSamples>::max();
+
+			sampler->ProcessViewParallel(params, view, *context);
+			sampler->PostProcess(*context);
 
 			// Unlock the texture
 			RHIUnlockTexture2D(textureRHI, 0, false);
@@ -34,7 +34,11 @@ public:
 	// ****************************************************************************************************
 	// Functions
 private:
-	void QueueGPUWriteSamplesToTexture();
+	// Samples with the sampler and context resolved by Activate() on the game thread, since the
+	// graph can't be built on the render thread.
+	void QueueGPUWriteSamplesToTexture(
+		UNoiseGraph::Sampler sampler, UNoiseGraph::ContextHandle context
+	);
 
 	void CompletedTask();
 	void FailedTask();
@@ -76,6 +80,6 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
 	bool RebuildNoiseGraph;
 
-	AlignedArray<TSamples> Samples;
+	UNoiseGraph::SamplingParameters Params;
 	FGPUFenceRHIRef Fence;
 };
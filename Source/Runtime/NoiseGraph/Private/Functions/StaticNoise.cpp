@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Functions/StaticNoise.h"
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Instantiated here so the templates are compiled even without a static graph in the module.
+	template struct StaticFractal<32, 16, StaticPerlin<32, 16>>;
+	template struct StaticWarp<32, 16, StaticFractal<32, 16, StaticSimplex<32, 16>>,
+		StaticCellular<32, 16, 0>>;
+}
+HWY_AFTER_NAMESPACE();
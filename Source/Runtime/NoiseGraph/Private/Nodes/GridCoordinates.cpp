@@ -0,0 +1,4 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Nodes/GridCoordinates.h"
\ No newline at end of file
@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Nodes/StaticNode.h"
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Instantiated here so the template is compiled even without a static graph in the module.
+	template class StaticNode<32, 16, StaticFractal<32, 16, StaticPerlin<32, 16>>>;
+}
+HWY_AFTER_NAMESPACE();
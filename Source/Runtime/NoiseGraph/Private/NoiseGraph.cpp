@@ -14,13 +14,21 @@
 #include "Nodes/NodeBaseSIMD.h"
 #include "Nodes/RandomNode.h"
 #include "Nodes/PerlinNode.h"
+#include "Nodes/SimplexNode.h"
 #include "Nodes/CellularNode.h"
 #include "Nodes/FractalNode.h"
 #include "Nodes/WarpNode.h"
 #include "Nodes/TreeNode.h"
 #include "Nodes/HeightmapNode.h"
+#include "Nodes/ResampleNode.h"
 
 #include "Nodes/InvertNode.h"
+#include "Nodes/FlattenNode.h"
+
+#include "Nodes/ProgramNode.h"
+
+#include <algorithm>
+#include <utility>
 
 // *************************************************************************************************
 // Function parameter signature (type and argX)
@@ -50,6 +58,16 @@ namespace SIMD::HWY_NAMESPACE
 		if constexpr (std::is_same<T, UNoiseGraph::Sampler>::value) {
 			return std::static_pointer_cast<NodeBaseSIMD<NOISEGRAPH_FP_PARAMS>>(t);
 		}
+		else if constexpr (std::is_same<T, std::vector<UNoiseGraph::Sampler>>::value) {
+			using NodePtr = std::shared_ptr<NodeBaseSIMD<NOISEGRAPH_FP_PARAMS>>;
+			std::vector<NodePtr> nodes;
+
+			for (const UNoiseGraph::Sampler& sampler : t) {
+				nodes.push_back(std::static_pointer_cast<NodePtr::element_type>(sampler));
+			}
+
+			return nodes;
+		}
 		else {
 			return t;
 		}
@@ -87,6 +105,90 @@ HWY_ATTR inline constexpr auto NoiseGraphMacroUCLASSArgumentRules(T t) {
 #define _NG_ARGS_UR_4 _NG_ARGS_UR_3, _NG_ARGS_UCLASS_RULES(arg4)
 #define _NG_ARGS_UR_5 _NG_ARGS_UR_4, _NG_ARGS_UCLASS_RULES(arg5)
 #define _NG_ARGS_UR(ArgCount) _NG_ARGS_UR_##ArgCount
+
+// Converts float into the raw bits of its FP
+// Converts FNoiseKey into its node's recipe
+template <typename T>
+inline NoiseNodeRecipe::Argument NoiseGraphMacroRecipeArgumentRules(T t) {
+	if constexpr (std::is_floating_point_v<T>) {
+		return NoiseFixedArgument{ UNoiseGraph::Fp(t).ToRaw() };
+	}
+	else if constexpr (std::is_same<T, FNoiseKey>::value) {
+		return t.GetRecipe();
+	}
+	else {
+		return static_cast<int32_t>(t);
+	}
+}
+
+inline NoiseNodeRecipePtr NoiseGraphMacroCreateRecipe(
+	NoiseNodeType type, std::vector<NoiseNodeRecipe::Argument> arguments
+) {
+	return std::make_shared<NoiseNodeRecipe>(NoiseNodeRecipe{ type, std::move(arguments) });
+}
+
+#define _NG_ARGS_RECIPE_RULES(arg) NoiseGraphMacroRecipeArgumentRules(arg)
+#define _NG_ARGS_RR_1 _NG_ARGS_RECIPE_RULES(arg1)
+#define _NG_ARGS_RR_2 _NG_ARGS_RR_1, _NG_ARGS_RECIPE_RULES(arg2)
+#define _NG_ARGS_RR_3 _NG_ARGS_RR_2, _NG_ARGS_RECIPE_RULES(arg3)
+#define _NG_ARGS_RR_4 _NG_ARGS_RR_3, _NG_ARGS_RECIPE_RULES(arg4)
+#define _NG_ARGS_RR_5 _NG_ARGS_RR_4, _NG_ARGS_RECIPE_RULES(arg5)
+#define _NG_ARGS_RR(ArgCount) _NG_ARGS_RR_##ArgCount
+
+// Creates the nodes of saved recipes, sharing the nodes that are shared between recipes.
+struct NoiseGraphLoader
+{
+	// Returns an empty key if the recipe (or one of its children) is invalid.
+	FNoiseKey Load(const NoiseNodeRecipePtr& recipe);
+
+	std::map<const NoiseNodeRecipe*, FNoiseKey> Loaded;
+};
+
+// Type of the recipe argument that a UFUNCTION argument is saved as.
+template <typename T>
+using NoiseGraphMacroRecipeArgument = std::conditional_t<
+	std::is_floating_point_v<T>, NoiseFixedArgument,
+	std::conditional_t<std::is_same_v<T, FNoiseKey>, NoiseNodeRecipePtr, int32_t>
+>;
+
+// Checks that the recipe's arguments match the UFUNCTION's, since blobs can be out of date.
+template <typename... Args, size_t... Indices>
+inline bool NoiseGraphMacroCheckArguments(
+	const NoiseNodeRecipe& recipe, std::index_sequence<Indices...>
+) {
+	return recipe.Arguments.size() == sizeof...(Args) && (
+		std::holds_alternative<NoiseGraphMacroRecipeArgument<Args>>(recipe.Arguments[Indices]) 
+		&& ...);
+}
+
+// Reverse of NoiseGraphMacroRecipeArgumentRules, with the same output as 
+// NoiseGraphMacroUCLASSArgumentRules: 
+// Converts raw bits into FP
+// Converts recipes into the Sampler of their loaded node
+template <typename T>
+inline auto NoiseGraphMacroLoadArgumentRules(
+	NoiseGraphLoader& loader, const NoiseNodeRecipe::Argument& argument
+) {
+	const auto& value = *std::get_if<NoiseGraphMacroRecipeArgument<T>>(&argument);
+
+	if constexpr (std::is_floating_point_v<T>) {
+		return UNoiseGraph::Fp::FromBase(static_cast<UNoiseGraph::Fp::base_type>(value.Raw));
+	}
+	else if constexpr (std::is_same<T, FNoiseKey>::value) {
+		return loader.Load(value).Get();
+	}
+	else {
+		return static_cast<T>(value);
+	}
+}
+
+#define _NG_LOAD_ARG(t, index) NoiseGraphMacroLoadArgumentRules<t>(loader, recipe.Arguments[index])
+#define _NG_LOAD_ARGS_1(t1) _NG_LOAD_ARG(t1, 0)
+#define _NG_LOAD_ARGS_2(t1, t2) _NG_LOAD_ARGS_1(t1), _NG_LOAD_ARG(t2, 1)
+#define _NG_LOAD_ARGS_3(t1, t2, t3) _NG_LOAD_ARGS_2(t1, t2), _NG_LOAD_ARG(t3, 2)
+#define _NG_LOAD_ARGS_4(t1, t2, t3, t4) _NG_LOAD_ARGS_3(t1, t2, t3), _NG_LOAD_ARG(t4, 3)
+#define _NG_LOAD_ARGS_5(t1, t2, t3, t4, t5) _NG_LOAD_ARGS_4(t1, t2, t3, t4), _NG_LOAD_ARG(t5, 4)
+#define _NG_LOAD_ARGS(ArgCount, ...) _NG_LOAD_ARGS_##ArgCount(__VA_ARGS__)
 #endif
 
 // *************************************************************************************************
@@ -165,14 +267,27 @@ namespace SIMD																					\
 #endif
 #endif
 
-// Creates the NoiseGraph's UFUNCTION implementation
+// Creates the NoiseGraph's UFUNCTION implementation, which records the node's recipe, and the
+// function that creates the node again from its recipe when loading a cooked graph.
 #if HWY_ONCE
 #ifdef NG_CREATE_UCLASS_IMPLEMENTATION
 #undef NG_CREATE_UCLASS_IMPLEMENTATION
 #endif
 #define NG_CREATE_UCLASS_IMPLEMENTATION(NodeName, ArgCount, ...)								\
 FNoiseKey UNoiseGraph::Get##NodeName(_NG_PARAMS(ArgCount, __VA_ARGS__)) {						\
-	return FNoiseKey(SIMD::DispatchCreate##NodeName##Node(_NG_ARGS_UR(ArgCount)));				\
+	return FNoiseKey(																			\
+		SIMD::DispatchCreate##NodeName##Node(_NG_ARGS_UR(ArgCount)),							\
+		NoiseGraphMacroCreateRecipe(NoiseNodeType::NodeName, { _NG_ARGS_RR(ArgCount) })			\
+	);																							\
+}																								\
+																								\
+static FNoiseKey::Sampler Load##NodeName##Node(													\
+	NoiseGraphLoader& loader, const NoiseNodeRecipe& recipe										\
+) {																								\
+	if (!NoiseGraphMacroCheckArguments<__VA_ARGS__>(											\
+		recipe, std::make_index_sequence<ArgCount>())) return nullptr;							\
+																								\
+	return SIMD::DispatchCreate##NodeName##Node(_NG_LOAD_ARGS(ArgCount, __VA_ARGS__));			\
 }
 #else
 #ifndef NG_CREATE_UCLASS_IMPLEMENTATION
@@ -196,6 +311,8 @@ NG_CREATE_DISPATCH_T(NodeName, TemplateType, ArgCount, __VA_ARGS__);
 // - A shared and unique node name. (E.g. Perlin, Cellular, Invert, etc...)
 // - A UFUNCTION on NoiseGraph.h with the signature "FNoiseKey Get[nodename]()"
 // - A NodeBaseSIMD<B, F> inherited node "[nodename]Node<B, F>".
+// - A NoiseNodeType "[nodename]", and its case in NoiseGraphLoader::Load(), so that it can be
+//			saved into cooked graphs.
 // - The constructor for the nodebaseSIMD node should be equivalent to the UFUNCTION, after 
 //			applying the rules defined in NoiseGraphMacroUCLASSArgumentRules(T). They are:
 //				- Floats turned into FixedPoint
@@ -232,32 +349,55 @@ NG_CREATE_UCLASS_IMPLEMENTATION(Random, 1, float);
 NG_CREATE_SIMD_DISPATCH(Perlin, 1, UNoiseGraph::Fp);
 NG_CREATE_UCLASS_IMPLEMENTATION(Perlin, 1, float);
 
+NG_CREATE_SIMD_DISPATCH(Simplex, 1, UNoiseGraph::Fp);
+NG_CREATE_UCLASS_IMPLEMENTATION(Simplex, 1, float);
+
 NG_CREATE_SIMD_NODE_T(Cellular, size_t, 2, UNoiseGraph::Fp, unsigned int);
 NG_CREATE_DISPATCH_T(Cellular, size_t, 2, UNoiseGraph::Fp, unsigned int);
 
 #if HWY_ONCE
-FNoiseKey UNoiseGraph::GetCellular(int feature, float seed, int maxPointsPerGrid) {
-	FNoiseKey::Sampler sampler;
-	unsigned int uPoints = static_cast<unsigned int>(maxPointsPerGrid);
-
+static FNoiseKey::Sampler CreateCellularSampler(
+	int feature, UNoiseGraph::Fp seed, unsigned int maxPointsPerGrid
+) {
 	if (feature == 0) {
-		sampler = SIMD::DispatchCreateCellularNode<0>(Fp(seed), uPoints);
+		return SIMD::DispatchCreateCellularNode<0>(seed, maxPointsPerGrid);
 	}
 	else if (feature == 1) {
-		sampler = SIMD::DispatchCreateCellularNode<1>(Fp(seed), uPoints);
+		return SIMD::DispatchCreateCellularNode<1>(seed, maxPointsPerGrid);
 	}
 	else if (feature == 2) {
-		sampler = SIMD::DispatchCreateCellularNode<2>(Fp(seed), uPoints);
+		return SIMD::DispatchCreateCellularNode<2>(seed, maxPointsPerGrid);
 	}
 	else {
 		UE_LOG(
 			LogTemp, Warning,
 			TEXT("Cellular feature %d not implemented. Defaulting to 0."), feature
 		);
-		sampler = SIMD::DispatchCreateCellularNode<0>(Fp(seed), uPoints);
+		return SIMD::DispatchCreateCellularNode<0>(seed, maxPointsPerGrid);
 	}
+}
+
+FNoiseKey UNoiseGraph::GetCellular(int feature, float seed, int maxPointsPerGrid) {
+	FNoiseKey::Sampler sampler = CreateCellularSampler(
+		feature, Fp(seed), static_cast<unsigned int>(maxPointsPerGrid));
+
+	return FNoiseKey(sampler, NoiseGraphMacroCreateRecipe(NoiseNodeType::Cellular, {
+		NoiseGraphMacroRecipeArgumentRules(feature),
+		NoiseGraphMacroRecipeArgumentRules(seed),
+		NoiseGraphMacroRecipeArgumentRules(maxPointsPerGrid)
+	}));
+}
+
+static FNoiseKey::Sampler LoadCellularNode(
+	NoiseGraphLoader& loader, const NoiseNodeRecipe& recipe
+) {
+	if (!NoiseGraphMacroCheckArguments<int, float, int>(
+		recipe, std::make_index_sequence<3>())) return nullptr;
 
-	return FNoiseKey(sampler);
+	return CreateCellularSampler(
+		_NG_LOAD_ARG(int, 0), _NG_LOAD_ARG(float, 1), 
+		static_cast<unsigned int>(_NG_LOAD_ARG(int, 2))
+	);
 }
 #endif
 
@@ -278,6 +418,167 @@ NG_CREATE_UCLASS_IMPLEMENTATION(Tree, 4, FNoiseKey, float, int, float);
 NG_CREATE_SIMD_DISPATCH(Heightmap, 3, FNoiseKey::Sampler, UNoiseGraph::Fp, UNoiseGraph::Fp);
 NG_CREATE_UCLASS_IMPLEMENTATION(Heightmap, 3, FNoiseKey, float, float);
 
+NG_CREATE_SIMD_DISPATCH(Resample, 2, FNoiseKey::Sampler, UNoiseGraph::Fp);
+NG_CREATE_UCLASS_IMPLEMENTATION(Resample, 2, FNoiseKey, float);
+
 // Modifiers
 NG_CREATE_SIMD_DISPATCH(Invert, 1, FNoiseKey::Sampler);
-NG_CREATE_UCLASS_IMPLEMENTATION(Invert, 1, FNoiseKey);
\ No newline at end of file
+NG_CREATE_UCLASS_IMPLEMENTATION(Invert, 1, FNoiseKey);
+
+NG_CREATE_SIMD_DISPATCH(Flatten, 1, FNoiseKey::Sampler);
+NG_CREATE_UCLASS_IMPLEMENTATION(Flatten, 1, FNoiseKey);
+
+// Compiler
+NG_CREATE_SIMD_DISPATCH(Program, 1, std::vector<FNoiseKey::Sampler>);
+
+#if HWY_ONCE
+UNoiseGraph::Sampler UNoiseGraph::Compile(const std::vector<Sampler>& roots) {
+	return SIMD::DispatchCreateProgramNode(roots);
+}
+#endif
+
+// *************************************************************************************************
+// Cooked Graphs
+
+#if HWY_ONCE
+FNoiseKey NoiseGraphLoader::Load(const NoiseNodeRecipePtr& recipe) {
+	if (!recipe) return FNoiseKey();
+
+	auto loaded = Loaded.find(recipe.get());
+	if (loaded != Loaded.end()) return loaded->second;
+
+	// Children first, so that nodes are never created with missing children.
+	for (const NoiseNodeRecipe::Argument& argument : recipe->Arguments) {
+		const NoiseNodeRecipePtr* child = std::get_if<NoiseNodeRecipePtr>(&argument);
+		if (child && !Load(*child).Get()) return FNoiseKey();
+	}
+
+	FNoiseKey::Sampler sampler;
+
+	switch (recipe->Type) {
+	case NoiseNodeType::Random:
+		sampler = LoadRandomNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Perlin:
+		sampler = LoadPerlinNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Simplex:
+		sampler = LoadSimplexNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Cellular:
+		sampler = LoadCellularNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Fractal:
+		sampler = LoadFractalNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Warp:
+		sampler = LoadWarpNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Tree:
+		sampler = LoadTreeNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Heightmap:
+		sampler = LoadHeightmapNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Resample:
+		sampler = LoadResampleNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Invert:
+		sampler = LoadInvertNode(*this, *recipe);
+		break;
+	case NoiseNodeType::Flatten:
+		sampler = LoadFlattenNode(*this, *recipe);
+		break;
+	default:
+		break;
+	}
+
+	if (!sampler) return FNoiseKey();
+
+	return Loaded[recipe.get()] = FNoiseKey(sampler, recipe);
+}
+
+UNoiseGraph::Recipe UNoiseGraph::GetRecipe() {
+	Recipe recipe;
+	if (!GetSampler()) return recipe;
+
+	recipe.Output = Output.GetRecipe();
+	recipe.BitsSize = uint8_t(Fp::BitsSize);
+	recipe.FractionSize = uint8_t(Fp::FractionSize);
+
+	for (const TPair<FName, FNoiseKey>& output : NamedOutputs) {
+		recipe.NamedOutputs.emplace_back(
+			TCHAR_TO_UTF8(*output.Key.ToString()), output.Value.GetRecipe());
+	}
+
+	// TMap's order depends on how it was filled, so it's sorted to keep blobs (and hashes) stable.
+	std::sort(recipe.NamedOutputs.begin(), recipe.NamedOutputs.end(),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+
+	return recipe;
+}
+
+bool UNoiseGraph::Cook() {
+	// Cleared first, so that the graph is built rather than loaded from an out of date blob.
+	CookedGraph.Reset();
+	CookedGraphHash = 0;
+
+	std::vector<uint8_t> blob;
+
+	if (!GetRecipe().Serialize(blob)) {
+		UE_LOG(LogNoiseGraph, Warning, 
+			TEXT("Could not cook NoiseGraph %s. It will be built at runtime."), *GetName());
+		return false;
+	}
+
+	CookedGraph.Append(blob.data(), blob.size());
+	CookedGraphHash = Recipe::Hash(blob.data(), blob.size());
+	return true;
+}
+
+bool UNoiseGraph::LoadCooked() {
+	Recipe recipe;
+
+	const uint8_t bitsSize = uint8_t(Fp::BitsSize);
+	const uint8_t fractionSize = uint8_t(Fp::FractionSize);
+
+	if (!Recipe::Deserialize(
+		CookedGraph.GetData(), CookedGraph.Num(), bitsSize, fractionSize, recipe)) {
+		UE_LOG(LogNoiseGraph, Warning, TEXT("Cooked NoiseGraph %s is invalid."), *GetName());
+		return false;
+	}
+
+	NoiseGraphLoader loader;
+	FNoiseKey output = loader.Load(recipe.Output);
+	TMap<FName, FNoiseKey> namedOutputs;
+
+	for (const auto& [name, node] : recipe.NamedOutputs) {
+		FNoiseKey key = loader.Load(node);
+
+		if (!key.Get()) {
+			output = FNoiseKey();
+			break;
+		}
+
+		namedOutputs.Add(FName(UTF8_TO_TCHAR(name.c_str())), key);
+	}
+
+	if (!output.Get()) {
+		UE_LOG(LogNoiseGraph, Warning, TEXT("Could not load cooked NoiseGraph %s."), *GetName());
+		return false;
+	}
+
+	Output = output;
+	NamedOutputs = MoveTemp(namedOutputs);
+	return true;
+}
+
+void UNoiseGraph::PreSave(FObjectPreSaveContext saveContext) {
+	Super::PreSave(saveContext);
+
+	// Only cooked games skip Build(). In the editor, blueprint changes should show up right away.
+	if (saveContext.IsCooking()) {
+		Cook();
+	}
+}
+#endif
@@ -2,17 +2,24 @@
 
 #include "NoiseGraphModule.h"
 #include "Modules/ModuleManager.h"
+#include <thread>
 
 DEFINE_LOG_CATEGORY(LogNoiseGraph);
 
 void FNoiseGraphModule::StartupModule()
 {
     // Code to execute after the module is loaded
+    TaskScheduler = std::make_unique<NoiseTaskScheduler>(
+        int(std::thread::hardware_concurrency()) - 1);
+    NoiseTaskScheduler::Shared = TaskScheduler.get();
 }
 
 void FNoiseGraphModule::ShutdownModule()
 {
     // Code to clean up when the module is unloaded
+    // Cancels the queued tasks, and joins the workers while it's still safe to.
+    NoiseTaskScheduler::Shared = nullptr;
+    TaskScheduler.reset();
 }
 
 
@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoiseGraphRecipe.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+// Blob layout (all integers are LEB128 varints, signed ones zigzag encoded):
+//		Magic "NGR", Version, fixed point BitsSize and FractionSize (bytes)
+//		Node count
+//		Nodes (children first): Type, Argument count, then per argument its Tag and value
+//		Output node index
+//		Named output count, then per output its name length, name bytes and node index
+namespace
+{
+	constexpr uint8_t Magic[3] = { 'N', 'G', 'R' };
+	constexpr uint8_t Version = 2;
+
+	// Same order as NoiseNodeRecipe::Argument
+	enum class ArgumentTag : uint8_t
+	{
+		Int,
+		Fixed,
+		Node
+	};
+
+	void WriteVarint(std::vector<uint8_t>& blob, uint64_t value) {
+		do {
+			uint8_t byte = value & 0x7F;
+			value >>= 7;
+			blob.push_back(value ? byte | 0x80 : byte);
+		} while (value);
+	}
+
+	void WriteSignedVarint(std::vector<uint8_t>& blob, int64_t value) {
+		WriteVarint(blob, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+	}
+
+	// Writes nodes children first, so that they're created before the nodes that use them.
+	// Nodes with the same content are written once, whether or not the graph shares them.
+	class NodeWriter
+	{
+	public:
+		// Writes the node and its children, if not written yet. Returns false if one of them
+		// has no recipe.
+		bool Write(const NoiseNodeRecipePtr& node) {
+			if (!node) return false;
+			if (Indices.count(node.get())) return true;
+
+			for (const NoiseNodeRecipe::Argument& argument : node->Arguments) {
+				const NoiseNodeRecipePtr* child = std::get_if<NoiseNodeRecipePtr>(&argument);
+				if (child && !Write(*child)) return false;
+			}
+
+			// Children are referenced by the index of their content, so two nodes have the same
+			// content exactly when they have the same type and arguments.
+			std::vector<uint8_t> content;
+			content.push_back(static_cast<uint8_t>(node->Type));
+			WriteVarint(content, node->Arguments.size());
+
+			for (const NoiseNodeRecipe::Argument& argument : node->Arguments) {
+				content.push_back(static_cast<uint8_t>(argument.index()));
+
+				if (const int32_t* value = std::get_if<int32_t>(&argument)) {
+					WriteSignedVarint(content, *value);
+				}
+				else if (const auto* fixed = std::get_if<NoiseFixedArgument>(&argument)) {
+					WriteSignedVarint(content, fixed->Raw);
+				}
+				else {
+					WriteVarint(content, Indices[std::get_if<NoiseNodeRecipePtr>(&argument)->get()]);
+				}
+			}
+
+			const auto [written, isNew] = Contents.emplace(std::move(content), Contents.size());
+			if (isNew) Nodes.insert(Nodes.end(), written->first.begin(), written->first.end());
+
+			Indices.emplace(node.get(), written->second);
+			return true;
+		}
+
+		std::vector<uint8_t> Nodes;
+		std::map<std::vector<uint8_t>, uint64_t> Contents;
+		std::map<const NoiseNodeRecipe*, uint64_t> Indices;
+	};
+
+	class BlobReader
+	{
+	public:
+		BlobReader(const uint8_t* data, size_t size) : Data(data), End(data + size) {}
+
+		bool ReadByte(uint8_t& byte) {
+			if (Data == End) return false;
+			byte = *Data++;
+			return true;
+		}
+
+		bool Read(uint64_t& value) {
+			value = 0;
+
+			for (int shift = 0; shift < 64; shift += 7) {
+				uint8_t byte;
+				if (!ReadByte(byte)) return false;
+
+				value |= uint64_t(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) return true;
+			}
+
+			return false;
+		}
+
+		bool ReadSigned(int64_t& value) {
+			uint64_t encoded;
+			if (!Read(encoded)) return false;
+
+			value = int64_t(encoded >> 1) ^ -int64_t(encoded & 1);
+			return true;
+		}
+
+		bool ReadBytes(size_t count, const uint8_t*& bytes) {
+			if (size_t(End - Data) < count) return false;
+
+			bytes = Data;
+			Data += count;
+			return true;
+		}
+
+		bool IsDone() const {
+			return Data == End;
+		}
+
+	private:
+		const uint8_t* Data;
+		const uint8_t* End;
+	};
+}
+
+bool NoiseGraphRecipe::Serialize(std::vector<uint8_t>& blob) const {
+	NodeWriter writer;
+
+	if (!writer.Write(Output)) return false;
+
+	for (const auto& [name, node] : NamedOutputs) {
+		if (!writer.Write(node)) return false;
+	}
+
+	blob.assign(std::begin(Magic), std::end(Magic));
+	blob.push_back(Version);
+	blob.push_back(BitsSize);
+	blob.push_back(FractionSize);
+	WriteVarint(blob, writer.Contents.size());
+	blob.insert(blob.end(), writer.Nodes.begin(), writer.Nodes.end());
+
+	WriteVarint(blob, writer.Indices[Output.get()]);
+	WriteVarint(blob, NamedOutputs.size());
+
+	for (const auto& [name, node] : NamedOutputs) {
+		WriteVarint(blob, name.size());
+		blob.insert(blob.end(), name.begin(), name.end());
+		WriteVarint(blob, writer.Indices[node.get()]);
+	}
+
+	return true;
+}
+
+bool NoiseGraphRecipe::Deserialize(
+	const uint8_t* data, size_t size, uint8_t bitsSize, uint8_t fractionSize,
+	NoiseGraphRecipe& recipe
+) {
+	BlobReader reader(data, size);
+	const uint8_t* header;
+
+	if (!reader.ReadBytes(sizeof(Magic) + 3, header)) return false;
+	if (!std::equal(std::begin(Magic), std::end(Magic), header)) return false;
+	if (header[sizeof(Magic)] != Version) return false;
+
+	// Raw bits of fixed arguments in another format would load as different numbers.
+	if (header[sizeof(Magic) + 1] != bitsSize) return false;
+	if (header[sizeof(Magic) + 2] != fractionSize) return false;
+
+	uint64_t nodeCount;
+	if (!reader.Read(nodeCount) || nodeCount > size) return false;
+
+	std::vector<NoiseNodeRecipePtr> nodes;
+	nodes.reserve(nodeCount);
+
+	for (uint64_t i = 0; i < nodeCount; ++i) {
+		std::shared_ptr<NoiseNodeRecipe> node = std::make_shared<NoiseNodeRecipe>();
+		uint8_t type;
+		uint64_t argumentCount;
+
+		if (!reader.ReadByte(type) || type >= uint8_t(NoiseNodeType::Count)) return false;
+		if (!reader.Read(argumentCount) || argumentCount > size) return false;
+
+		node->Type = NoiseNodeType(type);
+
+		for (uint64_t j = 0; j < argumentCount; ++j) {
+			uint8_t tag;
+			if (!reader.ReadByte(tag)) return false;
+
+			if (tag == uint8_t(ArgumentTag::Node)) {
+				// Children are written first, so only earlier nodes can be referenced.
+				uint64_t index;
+				if (!reader.Read(index) || index >= nodes.size()) return false;
+
+				node->Arguments.emplace_back(nodes[index]);
+				continue;
+			}
+
+			int64_t value;
+			if (!reader.ReadSigned(value)) return false;
+
+			if (tag == uint8_t(ArgumentTag::Int)) {
+				if (value != int32_t(value)) return false;
+				node->Arguments.emplace_back(int32_t(value));
+			}
+			else if (tag == uint8_t(ArgumentTag::Fixed)) {
+				node->Arguments.emplace_back(NoiseFixedArgument{ value });
+			}
+			else {
+				return false;
+			}
+		}
+
+		nodes.push_back(std::move(node));
+	}
+
+	uint64_t output, namedCount;
+	if (!reader.Read(output) || output >= nodes.size()) return false;
+	if (!reader.Read(namedCount) || namedCount > size) return false;
+
+	recipe.Output = nodes[output];
+	recipe.NamedOutputs.clear();
+	recipe.BitsSize = bitsSize;
+	recipe.FractionSize = fractionSize;
+
+	for (uint64_t i = 0; i < namedCount; ++i) {
+		uint64_t length, index;
+		const uint8_t* name;
+
+		if (!reader.Read(length) || !reader.ReadBytes(length, name)) return false;
+		if (!reader.Read(index) || index >= nodes.size()) return false;
+
+		recipe.NamedOutputs.emplace_back(
+			std::string(reinterpret_cast<const char*>(name), length), nodes[index]);
+	}
+
+	return reader.IsDone();
+}
+
+uint64_t NoiseGraphRecipe::Hash(const uint8_t* data, size_t size) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
+
+uint64_t NoiseGraphRecipe::Hash() const {
+	std::vector<uint8_t> blob;
+	if (!Serialize(blob)) return 0;
+
+	return Hash(blob.data(), blob.size());
+}
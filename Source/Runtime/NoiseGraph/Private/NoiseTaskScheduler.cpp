@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NoiseTaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+// *************************************************************************************************
+// NoiseTask
+
+NoiseTask::NoiseTask(
+	int priority, int tileCount,
+	std::function<void()> prepare,
+	std::function<void(int)> processTile,
+	std::function<void(NoiseTaskStatus)> finish
+) :
+	Priority(priority),
+	TileCount(tileCount),
+	Prepare(std::move(prepare)),
+	ProcessTile(std::move(processTile)),
+	Finish(std::move(finish)) {}
+
+void NoiseTask::Cancel() {
+	Cancelled = true;
+
+	if (Scheduler) {
+		Scheduler->Purge();
+	}
+}
+
+void NoiseTask::Wait() {
+	std::unique_lock<std::mutex> lock(Mutex);
+	DoneCondition.wait(lock, [&]() { return IsDone(); });
+}
+
+void NoiseTask::OnDone(Callback callback) {
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+
+		if (!IsDone()) {
+			Callbacks.push_back(std::move(callback));
+			return;
+		}
+	}
+
+	callback(Status);
+}
+
+void NoiseTask::Release() {
+	if (--References > 0) return;
+
+	const NoiseTaskStatus status = (Prepared && CompletedTiles == TileCount) ?
+		NoiseTaskStatus::Completed : NoiseTaskStatus::Cancelled;
+
+	if (Finish) {
+		Finish(status);
+	}
+
+	// Releases whatever the functions hold on to (contexts, samplers, etc...).
+	Prepare = nullptr;
+	ProcessTile = nullptr;
+	Finish = nullptr;
+
+	std::vector<Callback> callbacks;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Status = status;
+		callbacks.swap(Callbacks);
+	}
+
+	DoneCondition.notify_all();
+
+	for (Callback& callback : callbacks) {
+		callback(status);
+	}
+}
+
+// *************************************************************************************************
+// NoiseTaskScheduler
+
+NoiseTaskScheduler::NoiseTaskScheduler(int workerCount) {
+	for (int i = 0; i < std::max(workerCount, 1); ++i) {
+		Workers.emplace_back([this]() { Run(); });
+	}
+}
+
+NoiseTaskScheduler::~NoiseTaskScheduler() {
+	std::vector<Entry> remaining;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Stopping = true;
+		remaining.swap(Queue);
+	}
+
+	Condition.notify_all();
+
+	for (Entry& entry : remaining) {
+		entry.Task->Cancelled = true;
+		entry.Task->Release();
+	}
+
+	for (std::thread& worker : Workers) {
+		worker.join();
+	}
+}
+
+std::atomic<NoiseTaskScheduler*> NoiseTaskScheduler::Shared = nullptr;
+
+NoiseTaskScheduler& NoiseTaskScheduler::Get() {
+	NoiseTaskScheduler* scheduler = Shared;
+	assert(scheduler && "The NoiseGraph module isn't loaded.");
+	return *scheduler;
+}
+
+void NoiseTaskScheduler::Schedule(NoiseTaskHandle task) {
+	task->Scheduler = this;
+
+	uint64_t sequence;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		sequence = NextSequence++;
+	}
+
+	const int priority = task->Priority;
+
+	if (!Push(Entry{ priority, sequence, task })) {
+		task->Release();
+	}
+}
+
+void NoiseTaskScheduler::Run() {
+	while (true) {
+		Entry entry;
+
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			Condition.wait(lock, [&]() { return Stopping || !Queue.empty(); });
+
+			if (Queue.empty()) return;
+
+			std::pop_heap(Queue.begin(), Queue.end());
+			entry = std::move(Queue.back());
+			Queue.pop_back();
+		}
+
+		RunStep(std::move(entry));
+	}
+}
+
+void NoiseTaskScheduler::RunStep(Entry entry) {
+	// The worker owns the entry's reference until it is queued again, so it is the only one
+	// touching Prepared and NextTile.
+	NoiseTaskHandle task = entry.Task;
+
+	if (task->IsCancelled()) {
+		task->Release();
+		return;
+	}
+
+	NoiseTaskStatus queued = NoiseTaskStatus::Queued;
+	task->Status.compare_exchange_strong(queued, NoiseTaskStatus::Running);
+
+	if (!task->Prepared) {
+		task->Prepare();
+		task->Prepared = true;
+
+		if (task->TileCount == 0 || !Push(std::move(entry))) {
+			task->Release();
+		}
+
+		return;
+	}
+
+	// Takes a tile, then queues the task again right away so that other workers can take the
+	// next tiles (or a higher priority task can go first).
+	const int tile = task->NextTile++;
+	++task->References;
+
+	if (task->NextTile == task->TileCount || !Push(std::move(entry))) {
+		task->Release();
+	}
+
+	task->ProcessTile(tile);
+	++task->CompletedTiles;
+	task->Release();
+}
+
+bool NoiseTaskScheduler::Push(Entry entry) {
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+
+		// Checked under the lock, so that a concurrent Purge() can't miss the entry.
+		if (Stopping || entry.Task->IsCancelled()) return false;
+
+		Queue.push_back(std::move(entry));
+		std::push_heap(Queue.begin(), Queue.end());
+	}
+
+	Condition.notify_one();
+	return true;
+}
+
+void NoiseTaskScheduler::Purge() {
+	std::vector<Entry> purged;
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+
+		auto cancelled = std::partition(Queue.begin(), Queue.end(), [](const Entry& entry) {
+			return !entry.Task->IsCancelled();
+		});
+
+		std::move(cancelled, Queue.end(), std::back_inserter(purged));
+		Queue.erase(cancelled, Queue.end());
+		std::make_heap(Queue.begin(), Queue.end());
+	}
+
+	// Outside of the lock, since finishing a task calls back into user code.
+	for (Entry& entry : purged) {
+		entry.Task->Release();
+	}
+}
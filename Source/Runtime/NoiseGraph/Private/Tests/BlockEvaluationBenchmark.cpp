@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "hwy/highway.h"
+#include "AlignedArray.h"
+#include "Nodes/PerlinNode.h"
+#include "Nodes/FractalNode.h"
+#include "Nodes/WarpNode.h"
+#include "Functions/Perlin.h"
+#include "Functions/Fractal.h"
+#include "Functions/Warp.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Nodes as they were before they were evaluated in blocks: one virtual operator() per node
+	// per vector, with Fractal and Warp calling their function templates on their children.
+	template <size_t B, size_t F>
+	class VectorNode
+	{
+	public:
+		virtual ~VectorNode() = default;
+		virtual V<B, F> operator()(V<B, F> x, V<B, F> y, V<B, F> z) const = 0;
+	};
+
+	template <size_t B, size_t F>
+	class VectorPerlinNode : public VectorNode<B, F>
+	{
+	public:
+		VectorPerlinNode(FixedPoint<B, F> seed) : Seed(seed) {}
+
+		V<B, F> operator()(V<B, F> x, V<B, F> y, V<B, F> z) const override {
+			return Perlin<B, F>(x, y, z, Seed);
+		}
+
+		FixedPoint<B, F> Seed;
+	};
+
+	template <size_t B, size_t F>
+	class VectorFractalNode : public VectorNode<B, F>
+	{
+	public:
+		VectorFractalNode(std::shared_ptr<VectorNode<B, F>> base, unsigned int octaves)
+			: Base(base), Octaves(octaves) {}
+
+		V<B, F> operator()(V<B, F> x, V<B, F> y, V<B, F> z) const override {
+			return Fractal<B, F, const VectorNode<B, F>>(x, y, z, *Base, Octaves);
+		}
+
+		std::shared_ptr<VectorNode<B, F>> Base;
+		unsigned int Octaves;
+	};
+
+	template <size_t B, size_t F>
+	class VectorWarpNode : public VectorNode<B, F>
+	{
+	public:
+		VectorWarpNode(
+			std::shared_ptr<VectorNode<B, F>> base, std::shared_ptr<VectorNode<B, F>> shift,
+			unsigned int layers, FixedPoint<B, F> strength
+		) : Base(base), Shift(shift), Layers(layers), Strength(strength) {}
+
+		V<B, F> operator()(V<B, F> x, V<B, F> y, V<B, F> z) const override {
+			return Warp<B, F, const VectorNode<B, F>>(x, y, z, *Base, *Shift, Layers, Strength);
+		}
+
+		std::shared_ptr<VectorNode<B, F>> Base;
+		std::shared_ptr<VectorNode<B, F>> Shift;
+		unsigned int Layers;
+		FixedPoint<B, F> Strength;
+	};
+
+	// Fastest of a few runs of evaluate(), in milliseconds.
+	template <typename Func>
+	static double TimeBest(Func&& evaluate) {
+		double best = 0;
+
+		for (int run = 0; run < 5; ++run) {
+			const auto start = std::chrono::steady_clock::now();
+			evaluate();
+			const auto end = std::chrono::steady_clock::now();
+			const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+			best = (run == 0) ? ms : std::min(best, ms);
+		}
+
+		return best;
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+// Throughput of evaluating a graph a vector at a time through the per-vector virtual operator()
+// nodes used before block evaluation, and a block at a time through Evaluate(). Both read the
+// same precomputed coordinates, so only the evaluation of the nodes is compared.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FNoiseBlockEvaluationBenchmark, "NoiseGraph.Benchmarks.BlockEvaluation",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter
+)
+
+bool FNoiseBlockEvaluationBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace SIMD::HWY_NAMESPACE;
+	using fp = FixedPoint<32, 16>;
+	using Node = std::shared_ptr<NodeBaseSIMD<32, 16>>;
+
+	// Warp(Fractal(Perlin), Perlin), over a 64 x 64 x 32 grid
+	Node perlin = std::make_shared<PerlinNode<32, 16>>(fp(1));
+	Node fractal = std::make_shared<FractalNode<32, 16>>(perlin, 5);
+	Node shift = std::make_shared<PerlinNode<32, 16>>(fp(2));
+	Node warp = std::make_shared<WarpNode<32, 16>>(fractal, shift, 1, fp(2));
+
+	const int sizeX = 64;
+	const int sizeY = 64;
+	const int sizeZ = 32;
+	const int count = sizeX * sizeY * sizeZ;
+	const int lanes = int(hn::Lanes(D<32, 16>()));
+	const fp spacing = fp(1) >> 3;
+
+	using VectorNodePtr = std::shared_ptr<VectorNode<32, 16>>;
+	VectorNodePtr vectorPerlin = std::make_shared<VectorPerlinNode<32, 16>>(fp(1));
+	VectorNodePtr vectorFractal = std::make_shared<VectorFractalNode<32, 16>>(vectorPerlin, 5);
+	VectorNodePtr vectorShift = std::make_shared<VectorPerlinNode<32, 16>>(fp(2));
+	VectorNodePtr vectorWarp = std::make_shared<VectorWarpNode<32, 16>>(
+		vectorFractal, vectorShift, 1, fp(2)
+	);
+
+	AlignedArray<int32> x(count + NoiseBlock<32, 16>::Size);
+	AlignedArray<int32> y(count + NoiseBlock<32, 16>::Size);
+	AlignedArray<int32> z(count + NoiseBlock<32, 16>::Size);
+	AlignedArray<int32> perVector(count + NoiseBlock<32, 16>::Size);
+	AlignedArray<int32> perBlock(count + NoiseBlock<32, 16>::Size);
+
+	for (int i = 0; i < count; ++i) {
+		x[i] = (spacing * (i % sizeX)).ToRaw();
+		y[i] = (spacing * (i / sizeX % sizeY)).ToRaw();
+		z[i] = (spacing * (i / (sizeX * sizeY))).ToRaw();
+	}
+
+	NoiseExecutionContext context;
+	warp->PreProcess({
+		{ fp(0), spacing * sizeX }, { fp(0), spacing * sizeY }, { fp(0), spacing * sizeZ }
+	}, context);
+
+	const double vectorMs = TimeBest([&]() {
+		const D<32, 16> d;
+
+		for (int i = 0; i < count; i += lanes) {
+			const V<32, 16> sample = (*vectorWarp)(
+				hn::Load(d, x.GetPtr() + i),
+				hn::Load(d, y.GetPtr() + i),
+				hn::Load(d, z.GetPtr() + i)
+			);
+			hn::Store(sample, d, perVector.GetPtr() + i);
+		}
+	});
+
+	const double blockMs = TimeBest([&]() {
+		for (int i = 0; i < count; i += NoiseBlock<32, 16>::Size) {
+			const int blockCount = std::min(NoiseBlock<32, 16>::Size, count - i);
+			warp->Evaluate(NoiseBlock<32, 16>{
+				x.GetPtr() + i, y.GetPtr() + i, z.GetPtr() + i, blockCount, context
+			}, perBlock.GetPtr() + i);
+		}
+	});
+
+	warp->PostProcess(context);
+
+	TestTrue(TEXT("Block evaluation matches vector evaluation"),
+		std::equal(perVector.GetPtr(), perVector.GetPtr() + count, perBlock.GetPtr()));
+
+	AddInfo(FString::Printf(
+		TEXT("%d samples: per vector %.2f ms, per block %.2f ms (%.2fx)"),
+		count, vectorMs, blockMs, vectorMs / blockMs
+	));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "NoiseGraphRecipe.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+	NoiseNodeRecipePtr MakeRecipe(NoiseNodeType type, std::vector<NoiseNodeRecipe::Argument> args) {
+		return std::make_shared<NoiseNodeRecipe>(NoiseNodeRecipe{ type, std::move(args) });
+	}
+
+	NoiseNodeRecipePtr MakePerlin(int64_t seed) {
+		return MakeRecipe(NoiseNodeType::Perlin, { NoiseFixedArgument{ seed } });
+	}
+
+	NoiseNodeRecipePtr MakeFractal(NoiseNodeRecipePtr base) {
+		return MakeRecipe(NoiseNodeType::Fractal, { std::move(base), int32_t(4) });
+	}
+}
+
+// Blobs round trip, don't depend on which identical nodes are shared, and are tied to their
+// fixed point format.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FNoiseGraphRecipeTest, "NoiseGraph.Recipe.Blob",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter
+)
+
+bool FNoiseGraphRecipeTest::RunTest(const FString& Parameters)
+{
+	const NoiseNodeRecipePtr perlin = MakePerlin(65536);
+
+	// The same graph, with the Perlin node shared between the outputs or created twice.
+	NoiseGraphRecipe shared;
+	shared.BitsSize = 32;
+	shared.FractionSize = 16;
+	shared.Output = MakeFractal(perlin);
+	shared.NamedOutputs = { { "Density", MakeFractal(perlin) } };
+
+	NoiseGraphRecipe separate = shared;
+	separate.NamedOutputs = { { "Density", MakeFractal(MakePerlin(65536)) } };
+
+	std::vector<uint8_t> sharedBlob, separateBlob;
+	TestTrue(TEXT("Shared graph serializes"), shared.Serialize(sharedBlob));
+	TestTrue(TEXT("Separate graph serializes"), separate.Serialize(separateBlob));
+	TestTrue(TEXT("Identical nodes are written once"), sharedBlob == separateBlob);
+	TestEqual(TEXT("Identical graphs have the same hash"), shared.Hash(), separate.Hash());
+
+	NoiseGraphRecipe otherFormat = shared;
+	otherFormat.FractionSize = 20;
+	TestNotEqual(TEXT("The format is in the hash"), otherFormat.Hash(), shared.Hash());
+
+	NoiseGraphRecipe loaded;
+	TestFalse(TEXT("Blobs of another format are rejected"), NoiseGraphRecipe::Deserialize(
+		sharedBlob.data(), sharedBlob.size(), 32, 20, loaded));
+
+	if (TestTrue(TEXT("Blob loads"), NoiseGraphRecipe::Deserialize(
+		sharedBlob.data(), sharedBlob.size(), 32, 16, loaded))) {
+		TestTrue(TEXT("Identical outputs load as one node"),
+			loaded.Output == loaded.NamedOutputs[0].second);
+		TestEqual(TEXT("Loaded fraction size"), int(loaded.FractionSize), 16);
+	}
+
+	// More arguments than fit in a byte.
+	NoiseGraphRecipe wide;
+	wide.Output = MakeRecipe(
+		NoiseNodeType::Random, std::vector<NoiseNodeRecipe::Argument>(300, int32_t(1)));
+
+	std::vector<uint8_t> wideBlob;
+	TestTrue(TEXT("Wide node serializes"), wide.Serialize(wideBlob));
+
+	if (TestTrue(TEXT("Wide node loads"), NoiseGraphRecipe::Deserialize(
+		wideBlob.data(), wideBlob.size(), 0, 0, loaded))) {
+		TestEqual(TEXT("Wide node arguments"), int(loaded.Output->Arguments.size()), 300);
+	}
+
+	// Truncated blobs are invalid, rather than read out of bounds.
+	for (size_t size = 0; size < sharedBlob.size(); ++size) {
+		if (NoiseGraphRecipe::Deserialize(sharedBlob.data(), size, 32, 16, loaded)) {
+			AddError(FString::Printf(TEXT("Blob truncated to %d bytes loads"), int(size)));
+		}
+	}
+
+	return true;
+}
+
+#endif
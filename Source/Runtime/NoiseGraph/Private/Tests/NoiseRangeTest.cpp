@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "hwy/highway.h"
+#include "AlignedArray.h"
+#include "NoiseRange.h"
+#include "Nodes/GridCoordinates.h"
+#include "Nodes/PerlinNode.h"
+#include "Nodes/SimplexNode.h"
+#include "Nodes/RandomNode.h"
+#include "Nodes/CellularNode.h"
+#include "Nodes/TreeNode.h"
+#include "Nodes/FractalNode.h"
+#include "Nodes/WarpNode.h"
+#include "Nodes/HeightmapNode.h"
+#include "Nodes/InvertNode.h"
+#include "Nodes/RidgeNode.h"
+#include "Nodes/FlattenNode.h"
+#include "Nodes/ResampleNode.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Samples the node on the grid of params, the same way the sampler does, into values.
+	template <size_t B, size_t F>
+	static void SampleNodeGrid(
+		const NodeBaseSIMD<B, F>& node, const NoiseSamplingParameters<B, F>& params,
+		std::vector<T<B, F>>& values
+	) {
+		const int total = params.TotalSize();
+		const bool is3D = (params.GetDimensions() == 3);
+
+		AlignedArray<T<B, F>> out(total + NoiseBlock<B, F>::Size);
+		ScratchBuffer<B, F> x, y, z;
+		NoiseExecutionContext context;
+
+		node.PreProcessGrid(params, context);
+
+		for (int begin = 0; begin < total; begin += NoiseBlock<B, F>::Size) {
+			const int count = std::min(NoiseBlock<B, F>::Size, total - begin);
+
+			if (is3D) {
+				GenerateGridCoordinates<B, F, 3>(params, begin, count, x, y, z);
+			}
+			else {
+				GenerateGridCoordinates<B, F, 2>(params, begin, count, x, y, z);
+			}
+
+			node.Evaluate(
+				NoiseBlock<B, F>{ x, y, is3D ? z.Get() : nullptr, count, context },
+				out.GetPtr() + begin
+			);
+		}
+
+		node.PostProcess(context);
+		values.assign(out.GetPtr(), out.GetPtr() + total);
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+// Samples every node type, and compositions of them, over random 2D and 3D regions. Every sample
+// must be within GetRange() of the region, and SubdivideNoiseRegion() must never classify a brick
+// as Inside / Outside when its samples are on both sides of the threshold.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FNoiseRangeTest, "NoiseGraph.Range.Conservative",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter
+)
+
+bool FNoiseRangeTest::RunTest(const FString& Parameters)
+{
+	using namespace SIMD::HWY_NAMESPACE;
+	using fp = FixedPoint<32, 16>;
+	using Node = std::shared_ptr<NodeBaseSIMD<32, 16>>;
+
+	Node perlin = std::make_shared<PerlinNode<32, 16>>(fp(1));
+	Node simplex = std::make_shared<SimplexNode<32, 16>>(fp(2));
+	Node cellular = std::make_shared<CellularNode<32, 16, 0>>(fp(3), 2);
+	Node fractal = std::make_shared<FractalNode<32, 16>>(perlin, 4);
+	Node heightmap = std::make_shared<HeightmapNode<32, 16>>(fractal, fp(8), fp(-8));
+
+	const std::vector<std::pair<const TCHAR*, Node>> nodes = {
+		{ TEXT("Perlin"), perlin },
+		{ TEXT("Simplex"), simplex },
+		{ TEXT("Random"), std::make_shared<RandomNode<32, 16>>(fp(4)) },
+		{ TEXT("Cellular0"), cellular },
+		{ TEXT("Cellular1"), std::make_shared<CellularNode<32, 16, 1>>(fp(5), 3) },
+		{ TEXT("Cellular2"), std::make_shared<CellularNode<32, 16, 2>>(fp(6), 1) },
+		{ TEXT("Tree"), std::make_shared<TreeNode<32, 16>>(perlin, fp(7), 0, fp(0.5)) },
+		{ TEXT("Fractal(Perlin)"), fractal },
+		{ TEXT("Fractal(Cellular0)"), std::make_shared<FractalNode<32, 16>>(
+			cellular, 3, fp(0.6), fp(2.5)) },
+		{ TEXT("Warp(Perlin, Simplex)"), std::make_shared<WarpNode<32, 16>>(
+			perlin, simplex, 2, fp(1.5)) },
+		{ TEXT("Warp(Fractal, Cellular0)"), std::make_shared<WarpNode<32, 16>>(
+			fractal, cellular, 1, fp(0.75)) },
+		{ TEXT("Heightmap(Fractal)"), heightmap },
+		{ TEXT("Invert(Simplex)"), std::make_shared<InvertNode<32, 16>>(simplex) },
+		{ TEXT("Ridge(Fractal)"), std::make_shared<RidgeNode<32, 16>>(fractal) },
+		{ TEXT("Ridge(Invert(Cellular0))"), std::make_shared<RidgeNode<32, 16>>(
+			std::make_shared<InvertNode<32, 16>>(cellular)) },
+		{ TEXT("Invert(Heightmap)"), std::make_shared<InvertNode<32, 16>>(heightmap) },
+		{ TEXT("Ridge(Heightmap)"), std::make_shared<RidgeNode<32, 16>>(heightmap) },
+		{ TEXT("Heightmap(Warp)"), std::make_shared<HeightmapNode<32, 16>>(
+			std::make_shared<WarpNode<32, 16>>(simplex, perlin, 1, fp(1)), fp(4), fp(-4)) },
+		{ TEXT("Fractal(Heightmap)"), std::make_shared<FractalNode<32, 16>>(
+			std::make_shared<HeightmapNode<32, 16>>(perlin, fp(2), fp(-2)), 3) },
+		{ TEXT("Flatten(Simplex)"), std::make_shared<FlattenNode<32, 16>>(simplex) },
+		{ TEXT("Resample(Perlin)"), std::make_shared<ResampleNode<32, 16>>(perlin, fp(4)) },
+		{ TEXT("Resample(Warp)"), std::make_shared<ResampleNode<32, 16>>(
+			std::make_shared<WarpNode<32, 16>>(perlin, simplex, 1, fp(2)), fp(0.5)) },
+		{ TEXT("Warp(Resample(Fractal), Perlin)"), std::make_shared<WarpNode<32, 16>>(
+			std::make_shared<ResampleNode<32, 16>>(fractal, fp(2)), perlin, 3, fp(1)) },
+		{ TEXT("Fractal(Resample(Simplex))"), std::make_shared<FractalNode<32, 16>>(
+			std::make_shared<ResampleNode<32, 16>>(simplex, fp(1)), 3) },
+	};
+
+	// Spacings that are exact in fixed point, so bricks' coordinates match the region's.
+	const fp spacings[] = { fp(1) >> 4, fp(1) >> 2, fp(1), fp(1.5) };
+
+	// Fixed seed, so failures can be reproduced.
+	std::mt19937 random(12345);
+	// Around the heightmaps' surfaces, so that some of their regions are split.
+	std::uniform_int_distribution<int32> anyStart(-(16 << 16), 16 << 16);
+	std::uniform_int_distribution<int> anySpacing(0, 3);
+	std::uniform_int_distribution<int> anySize(1, 16);
+
+	std::vector<int32> values;
+	std::vector<NoiseSamplingBrick<32, 16>> bricks;
+	int outOfRange = 0;
+	int misclassified = 0;
+
+	for (const auto& [name, node] : nodes) {
+		for (int region = 0; region < 64; ++region) {
+			const int dimensions = (region % 2 == 0) ? 2 : 3;
+
+			NoiseSamplingParameters<32, 16> params(spacings[anySpacing(random)]);
+			std::vector<int> sizes;
+
+			for (int axis = 0; axis < dimensions; ++axis) {
+				sizes.push_back(anySize(random));
+				params.Add(fp::FromBase(anyStart(random)), sizes.back());
+			}
+
+			const NoiseRange<32, 16> range = node->GetRange(params.GetBounds());
+			SampleNodeGrid<32, 16>(*node, params, values);
+
+			for (int32 value : values) {
+				if (value >= range.Min.ToRaw() && value <= range.Max.ToRaw()) continue;
+
+				if (outOfRange++ < 10) {
+					AddError(FString::Printf(
+						TEXT("%s (%dD, region %d): sample %d is out of [%d, %d]"),
+						name, dimensions, region, value, range.Min.ToRaw(), range.Max.ToRaw()
+					));
+				}
+			}
+
+			// Thresholds at a sample, so some bricks are on the isosurface, or at the heightmaps'
+			// surface.
+			std::uniform_int_distribution<int> anySample(0, int(values.size()) - 1);
+			const fp threshold = ((region / 2) % 2 == 0) ?
+				fp::FromBase(values[anySample(random)]) : (fp(1) >> 1);
+
+			bricks.clear();
+			SubdivideNoiseRegion<32, 16>(
+				params, std::vector<int>(dimensions, 0), 2, threshold,
+				[&](const std::vector<NoiseSamplingBound<32, 16>>& bounds) {
+					return node->GetRange(bounds);
+				},
+				bricks
+			);
+
+			for (const NoiseSamplingBrick<32, 16>& brick : bricks) {
+				if (brick.Class == NoiseRegionClass::Mixed) continue;
+
+				const int brickSizeZ = (dimensions == 3) ? brick.Params.Size(2) : 1;
+				const int offsetZ = (dimensions == 3) ? brick.Offsets[2] : 0;
+				bool isCrossed = false;
+
+				for (int bz = 0; bz < brickSizeZ; ++bz) {
+					for (int by = 0; by < brick.Params.Size(1); ++by) {
+						for (int bx = 0; bx < brick.Params.Size(0); ++bx) {
+							const int index = (brick.Offsets[0] + bx) + sizes[0] * (
+								(brick.Offsets[1] + by) + sizes[1] * (offsetZ + bz));
+							const bool isInside = (values[index] >= threshold.ToRaw());
+							isCrossed |= (isInside != (brick.Class == NoiseRegionClass::Inside));
+						}
+					}
+				}
+
+				if (isCrossed && misclassified++ < 10) {
+					AddError(FString::Printf(
+						TEXT("%s (%dD, region %d): brick at (%d, %d) crosses threshold %d"),
+						name, dimensions, region, brick.Offsets[0], brick.Offsets[1],
+						threshold.ToRaw()
+					));
+				}
+			}
+		}
+	}
+
+	TestEqual(TEXT("Samples out of range"), outOfRange, 0);
+	TestEqual(TEXT("Misclassified bricks"), misclassified, 0);
+	return true;
+}
+
+#endif
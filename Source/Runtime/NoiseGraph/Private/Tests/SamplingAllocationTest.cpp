@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "HAL/MemoryBase.h"
+#include "AlignedArray.h"
+#include "NoiseSampleStats.h"
+#include "NoiseSamplingParameters.h"
+#include "Nodes/PerlinNode.h"
+#include "Nodes/SimplexNode.h"
+#include "Nodes/CellularNode.h"
+#include "Nodes/FractalNode.h"
+#include "Nodes/WarpNode.h"
+#include "Nodes/HeightmapNode.h"
+#include "Nodes/ResampleNode.h"
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Copied into every block, so it must stay trivially copyable (no allocations).
+static_assert(std::is_trivially_copyable_v<NoiseSamplingParameters<32, 16>>);
+
+namespace
+{
+	// Forwards every call to the allocator it replaces, and counts the allocations made by the
+	// thread that installed it. Other threads keep allocating while it is installed, but aren't
+	// counted.
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* inner) : Inner(inner) {}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override {
+			if (IsCounting) ++AllocationCount;
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override {
+			if (IsCounting && Count > 0) ++AllocationCount;
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override {
+			Inner->Free(Original);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override {
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override {
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual void Trim(bool bTrimThreadCaches) override {
+			Inner->Trim(bTrimThreadCaches);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override {
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override {
+			return Inner->GetDescriptiveName();
+		}
+
+		// Whether this thread's allocations are counted, and how many it made while they were.
+		static thread_local bool IsCounting;
+		static thread_local int AllocationCount;
+
+	private:
+		FMalloc* Inner;
+	};
+
+	thread_local bool FCountingMalloc::IsCounting = false;
+	thread_local int FCountingMalloc::AllocationCount = 0;
+
+	// Installs a FCountingMalloc in GMalloc for its lifetime.
+	class FScopedCountingMalloc
+	{
+	public:
+		FScopedCountingMalloc() : Previous(GMalloc), Counting(GMalloc) {
+			GMalloc = &Counting;
+		}
+
+		~FScopedCountingMalloc() {
+			GMalloc = Previous;
+		}
+
+		// Number of allocations this thread makes in func().
+		template <typename Func>
+		int Count(Func&& func) {
+			FCountingMalloc::AllocationCount = 0;
+			FCountingMalloc::IsCounting = true;
+			func();
+			FCountingMalloc::IsCounting = false;
+			return FCountingMalloc::AllocationCount;
+		}
+
+	private:
+		FMalloc* Previous;
+		FCountingMalloc Counting;
+	};
+}
+
+// Samples real nodes through NodeBase::Process(), the path of UNoiseGraph::Sample(), and counts
+// the allocations made while sampling. PreProcess() may allocate (caches, lattices), and so may
+// the first call on a thread (its scratch arena), but sampling must not allocate for any vector
+// or block of samples.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FNoiseSamplingAllocationTest, "NoiseGraph.Sampling.NoAllocations",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter
+)
+
+bool FNoiseSamplingAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace SIMD::HWY_NAMESPACE;
+	using fp = FixedPoint<32, 16>;
+	using Node = std::shared_ptr<NodeBaseSIMD<32, 16>>;
+
+	Node perlin = std::make_shared<PerlinNode<32, 16>>(fp(1));
+	Node simplex = std::make_shared<SimplexNode<32, 16>>(fp(2));
+	Node fractal = std::make_shared<FractalNode<32, 16>>(perlin, 4);
+
+	const std::vector<std::pair<const TCHAR*, Node>> nodes = {
+		{ TEXT("Perlin"), perlin },
+		{ TEXT("Simplex"), simplex },
+		{ TEXT("Cellular"), std::make_shared<CellularNode<32, 16, 0>>(fp(3), 2) },
+		{ TEXT("Fractal(Perlin)"), fractal },
+		{ TEXT("Warp(Fractal, Simplex)"), std::make_shared<WarpNode<32, 16>>(
+			fractal, simplex, 2, fp(1.5)) },
+		{ TEXT("Heightmap(Fractal)"), std::make_shared<HeightmapNode<32, 16>>(
+			fractal, fp(8), fp(-8)) },
+		{ TEXT("Resample(Fractal)"), std::make_shared<ResampleNode<32, 16>>(fractal, fp(2)) },
+	};
+
+	// A 2D and a 3D region of many blocks.
+	NoiseSamplingParameters<32, 16> region2D(fp(1) >> 2);
+	region2D.Add(fp(-8), 256);
+	region2D.Add(fp(4), 128);
+
+	NoiseSamplingParameters<32, 16> region3D(fp(1) >> 2);
+	region3D.Add(fp(-8), 64);
+	region3D.Add(fp(4), 32);
+	region3D.Add(fp(0), 16);
+
+	AlignedArray<int32> values(region2D.TotalSize());
+	AlignedArray<float> floatValues(region2D.TotalSize());
+	NoiseSampleStats<32, 16> stats;
+
+	FScopedCountingMalloc counter;
+	int allocatingNodes = 0;
+
+	for (const auto& [name, node] : nodes) {
+		for (const NoiseSamplingParameters<32, 16>* params : { &region2D, &region3D }) {
+			NoiseExecutionContext context;
+			node->PreProcessGrid(*params, context);
+
+			// Warms up this thread's scratch arena.
+			node->Process(*params, values, context);
+
+			const int allocations = counter.Count([&] {
+				node->Process(*params, values, context);
+				node->Process(*params, floatValues, context, &stats);
+			});
+
+			node->PostProcess(context);
+
+			const int blockCount = 2 * (params->TotalSize() / NoiseBlock<32, 16>::Size);
+			AddInfo(FString::Printf(
+				TEXT("%s (%dD): %d allocations for %d blocks"),
+				name, params->GetDimensions(), allocations, blockCount
+			));
+
+			if (allocations != 0) {
+				++allocatingNodes;
+				AddError(FString::Printf(
+					TEXT("%s (%dD) allocates while sampling"), name, params->GetDimensions()
+				));
+			}
+		}
+	}
+
+	TestEqual(TEXT("Nodes that allocate while sampling"), allocatingNodes, 0);
+	return true;
+}
+
+#endif
@@ -16,91 +16,209 @@
 #include "Numerics/FixedPointConstants.h"
 #include "Numerics/FixedPointSIMD.h"
 #include "Mathematics/Indexing.h"
+#include "AlignedArray.h"
+#include "NoiseSamplingParameters.h"
 
 #include "Random.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 HWY_BEFORE_NAMESPACE();
 namespace SIMD::HWY_NAMESPACE
 {
-	/// <summary>
-	/// Features:
-	/// 0: Return distance to closest cell point
-	/// 1: Return cell's random value
-	/// 2: Return dist between cell's two closest points
-	/// </summary>
-	template <size_t B, size_t F, size_t Feature>
-	inline constexpr auto Cellular(
-		V<B, F> x, V<B, F> y,
-		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid = 1
+	// Largest cache GetCellularCache() builds, in values (16 MB for 32 bit values). Larger bounds
+	// are sampled without a cache.
+	inline constexpr int CellularCacheMaxValues = 1 << 22;
+
+	// Feature points of a box of cells, built by GetCellularCache() so that Cellular() loads them
+	// instead of hashing every neighbour cell of every sample.
+	//
+	// Cells are stored x first. Each cell is its number of points (as Cellular() counts them),
+	// followed by the coordinates of each of its points.
+	template <size_t B, size_t F>
+	struct CellularCache
+	{
+		AlignedArray<T<B, F>> Values;
+		int Begin[3] = {};			// Grid coordinates of the cell at index 0
+		int Size[3] = { 1, 1, 1 };	// Number of cells on each axis
+		int Dimensions = 0;
+		int Stride = 0;				// Values per cell
+		bool IsValid = false;
+	};
+
+	// Number of points in a cell, as a fixed point integer. Uniformly distributed in
+	// [1, maxPointsPerGrid].
+	template <size_t B, size_t F>
+	HWY_INLINE V<B, F> CellularPointCount(V<B, F> gridhash, unsigned int maxPointsPerGrid) {
+		return And(
+			FPAdd<B, F>(FPMul<B, F>(gridhash, maxPointsPerGrid), 1),
+			FixedPoint<B, F>::IntegerMask
+		);
+	}
+
+	// Point i of the cell at (gridX, gridY).
+	template <size_t B, size_t F>
+	HWY_INLINE void CellularPoint(
+		V<B, F> gridhash, V<B, F> gridX, V<B, F> gridY, int i, V<B, F>& pointX, V<B, F>& pointY
+	) {
+		using fp = FixedPoint<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+
+		pointX = FPAdd<B, F>(
+			gridX,
+			Random<B, F>(gridhash, FPBroadcast<B, F>(fpc::Sqrt2), fp::FromBase(i))
+		);
+		pointY = FPAdd<B, F>(
+			gridY,
+			Random<B, F>(gridhash, FPBroadcast<B, F>(fpc::Sqrt3), fp::FromBase(i))
+		);
+	}
+
+	// Point i of the cell at (gridX, gridY, gridZ).
+	template <size_t B, size_t F>
+	HWY_INLINE void CellularPoint(
+		V<B, F> gridhash, V<B, F> gridX, V<B, F> gridY, V<B, F> gridZ, int i,
+		V<B, F>& pointX, V<B, F>& pointY, V<B, F>& pointZ
 	) {
-		static_assert(Feature >= 0 && Feature <= 2, "Feature not defined.");
 		using fp = FixedPoint<B, F>;
 		using fpc = FixedPointConstant<B, F>;
+
+		CellularPoint<B, F>(gridhash, gridX, gridY, i, pointX, pointY);
+		pointZ = FPAdd<B, F>(gridZ, Random<B, F>(
+			gridhash, FPBroadcast<B, F>(fpc::InvSqrt3), fp::FromBase(i)
+		));
+	}
+
+	// Moore neighbourhood, nearest cells first: the sample's own cell, then the cells sharing an
+	// edge with it, then the ones sharing a corner.
+	inline constexpr int CellularNearestOrder2D[9][2] = {
+		{ 0, 0 },
+		{ -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+		{ -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 },
+	};
+
+	// Same as above, in 3D: the sample's own cell, then the cells sharing a face, an edge and a
+	// corner with it.
+	inline constexpr int CellularNearestOrder3D[27][3] = {
+		{ 0, 0, 0 },
+		{ -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+		{ -1, -1, 0 }, { 1, -1, 0 }, { -1, 1, 0 }, { 1, 1, 0 },
+		{ -1, 0, -1 }, { 1, 0, -1 }, { -1, 0, 1 }, { 1, 0, 1 },
+		{ 0, -1, -1 }, { 0, 1, -1 }, { 0, -1, 1 }, { 0, 1, 1 },
+		{ -1, -1, -1 }, { 1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 },
+		{ -1, -1, 1 }, { 1, -1, 1 }, { -1, 1, 1 }, { 1, 1, 1 },
+	};
+
+	// Squared distance from the samples to the closest edge of their neighbour cells on an axis,
+	// which no point of those cells is closer than. Exact, so that it is never larger than the
+	// squared distance to any of their points.
+	template <size_t B, size_t F>
+	HWY_INLINE void CellularEdgeDistance(V<B, F> c, V<B, F>& lower, V<B, F>& upper) {
+		const V<B, F> c0 = FPFloor<B, F>(c);
+		lower = FPSquare<B, F>(FPSub<B, F>(c, c0));
+		upper = FPSquare<B, F>(FPSub<B, F>(FPAdd<B, F>(c0, 1), c));
+	}
+
+	template <size_t B, size_t F>
+	HWY_INLINE V<B, F> CellularEdgeDistance(int offset, V<B, F> lower, V<B, F> upper) {
+		return (offset < 0) ? lower : ((offset > 0) ? upper : Zero<V<B, F>>());
+	}
+
+	// Searches the moore neighbourhood of the samples for the closest points.
+	// cell(dx, dy, key) returns the number of points of the neighbour cell (dx, dy), and sets a
+	// key that point(key, dx, dy, i, pointX, pointY) finds its points with.
+	//
+	// Cells are searched nearest first, and cells that are further from every sample than its
+	// closest point so far are skipped. Feature 2 measures to the point that was closest before
+	// the closest one, which depends on the order, so it searches in scan order (dy, then dx).
+	// Feature 1 keeps the point that comes first in scan order when points are equally close, so
+	// that every order returns the same cell.
+	template <size_t B, size_t F, size_t Feature, typename CellFunc, typename PointFunc>
+	HWY_INLINE auto CellularSearch(
+		V<B, F> x, V<B, F> y, FixedPoint<B, F> seed, CellFunc&& cell, PointFunc&& point
+	) {
+		static_assert(Feature >= 0 && Feature <= 2, "Feature not defined.");
+		using fp = FixedPoint<B, F>;
 		using vec = V<B, F>;
 		using mask = M<B, F>;
-
-		// Grid coordinates
-		vec x0 = FPFloor<B, F>(x);
-		vec y0 = FPFloor<B, F>(y);
+		const D<B, F> d;
 
 		vec minDist = FPBroadcast<B, F>(FixedPointConstant<B, F>::Max);
 		vec minX = x;
 		vec minY = y;
 		vec minId = Zero<vec>();
+		vec minRank = Zero<vec>();
 		vec secondMinX = minX;
 		vec secondMinY = minY;
 
-		// Loops through moore neighbourhood
-		for (int dy = -1; dy <= 1; dy++) {
-			for (int dx = -1; dx <= 1; dx++) {
+		vec lowerX, upperX, lowerY, upperY;
+		CellularEdgeDistance<B, F>(x, lowerX, upperX);
+		CellularEdgeDistance<B, F>(y, lowerY, upperY);
+
+		for (int k = 0; k < 9; k++) {
+			const int dx = (Feature == 2) ? (k % 3 - 1) : CellularNearestOrder2D[k][0];
+			const int dy = (Feature == 2) ? (k / 3 - 1) : CellularNearestOrder2D[k][1];
+
+			// Skips the cell if none of its points can be closer
+			vec edgeDist = FPAdd<B, F>(
+				CellularEdgeDistance<B, F>(dx, lowerX, upperX),
+				CellularEdgeDistance<B, F>(dy, lowerY, upperY)
+			);
+			mask isFurther = (Feature == 1) ? hn::Gt(edgeDist, minDist) : hn::Ge(edgeDist, minDist);
+
+			if (hn::AllTrue(d, isFurther)) {
+				continue;
+			}
+
+			// Position of the cell in scan order
+			const int rank = (dy + 1) * 3 + (dx + 1);
 
-				vec gridX = FPAdd<B, F>(x0, dx);
-				vec gridY = FPAdd<B, F>(y0, dy);
-				vec gridhash = Random<B, F>(gridX, gridY, seed);
+			vec key;
+			vec points = cell(dx, dy, key);
+			int maxPointCount = fp::FromBase(ReduceMax(points)).ToInt();
 
-				// Formula to uniformly determines the number of points in a grid cell
-				vec points = And(
-					FPAdd<B, F>(FPMul<B, F>(gridhash, maxPointsPerGrid), 1),
-					FixedPoint<B, F>::IntegerMask
+			// Loops through each point in the cell
+			for (int i = 0; i < maxPointCount; i++) {
+				vec pointX, pointY;
+				point(key, dx, dy, i, pointX, pointY);
+
+				vec dist = FPAdd<B, F>(
+					FPSquare<B, F>(FPSub<B, F>(pointX, x)),
+					FPSquare<B, F>(FPSub<B, F>(pointY, y))
 				);
-				int maxPointCount = fp::FromBase(ReduceMax(points)).ToInt();
 
-				// Loops through each point in the cell
-				for (int i = 0; i < maxPointCount; i++) {
-					vec pointX = FPAdd<B, F>(
-						gridX, 
-						Random<B, F>(gridhash, FPBroadcast<B, F>(fpc::Sqrt2), fp::FromBase(i))
-					);
-					vec pointY = FPAdd<B, F>(
-						gridY, 
-						Random<B, F>(gridhash, FPBroadcast<B, F>(fpc::Sqrt3), fp::FromBase(i))
-					);
+				// Updates the min variables if new point is closest point
+				mask validPointMask = hn::Lt(FPBroadcast<B, F>(i), points);
+				mask isMinMask = hn::Lt(dist, minDist);
 
-					vec dist = FPAdd<B, F>(
-						FPSquare<B, F>(FPSub<B, F>(pointX, x)),
-						FPSquare<B, F>(FPSub<B, F>(pointY, y))
-					);
+				if constexpr (Feature == 1) {
+					isMinMask = hn::Or(isMinMask, hn::And(
+						hn::Eq(dist, minDist), hn::Lt(Broadcast<vec>(rank), minRank)
+					));
+				}
 
-					// Updates the min variables if new point is closest point
-					mask validPointMask = hn::Lt(FPBroadcast<B, F>(i), points);
-					mask isMinMask = hn::Lt(dist, minDist);
-					mask newValueMask = hn::And(isMinMask, validPointMask);
-					minDist = hn::IfThenElse(newValueMask, dist, minDist);
+				mask newValueMask = hn::And(isMinMask, validPointMask);
+				minDist = hn::IfThenElse(newValueMask, dist, minDist);
 
-					if constexpr (Feature == 2) {
-						secondMinX = hn::IfThenElse(newValueMask, minX, secondMinX);
-						secondMinY = hn::IfThenElse(newValueMask, minY, secondMinY);
-					}
+				if constexpr (Feature == 2) {
+					secondMinX = hn::IfThenElse(newValueMask, minX, secondMinX);
+					secondMinY = hn::IfThenElse(newValueMask, minY, secondMinY);
+				}
 
-					if constexpr (Feature == 1 || Feature == 2) {
-						minX = hn::IfThenElse(newValueMask, pointX, minX);
-						minY = hn::IfThenElse(newValueMask, pointY, minY);
-						minId = hn::IfThenElse(newValueMask, Broadcast<vec>(i), minId);
-					}
+				if constexpr (Feature == 1 || Feature == 2) {
+					minX = hn::IfThenElse(newValueMask, pointX, minX);
+					minY = hn::IfThenElse(newValueMask, pointY, minY);
+					minId = hn::IfThenElse(newValueMask, Broadcast<vec>(i), minId);
+				}
 
+				if constexpr (Feature == 1) {
+					minRank = hn::IfThenElse(newValueMask, Broadcast<vec>(rank), minRank);
 				}
 			}
 		}
+
 		if constexpr (Feature == 0) {
 			return FPSqrt<B, F>(minDist);
 		}
@@ -115,96 +233,99 @@ namespace SIMD::HWY_NAMESPACE
 		}
 	}
 
-
-	/// <summary>
-	/// Features:
-	/// 0: Return distance to closest cell point
-	/// 1: Return cell's random value
-	/// 2: Return dist between cell's two closest points
-	/// </summary>
-	template <size_t B, size_t F, size_t Feature>
-	inline constexpr auto Cellular(
-		V<B, F> x, V<B, F> y, V<B, F> z, 
-		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid = 1
+	// Same as above, in 3D. Feature 2 searches in scan order (dz, then dy, then dx).
+	template <size_t B, size_t F, size_t Feature, typename CellFunc, typename PointFunc>
+	HWY_INLINE auto CellularSearch(
+		V<B, F> x, V<B, F> y, V<B, F> z, FixedPoint<B, F> seed, CellFunc&& cell, PointFunc&& point
 	) {
 		static_assert(Feature >= 0 && Feature <= 2, "Feature not defined.");
 		using fp = FixedPoint<B, F>;
-		using fpc = FixedPointConstant<B, F>;
 		using vec = V<B, F>;
 		using mask = M<B, F>;
-
-		// Grid coordinates
-		vec x0 = FPFloor<B, F>(x);
-		vec y0 = FPFloor<B, F>(y);
-		vec z0 = FPFloor<B, F>(z);
+		const D<B, F> d;
 
 		vec minDist = FPBroadcast<B, F>(FixedPointConstant<B, F>::Max);
 		vec minX = x;
 		vec minY = y;
 		vec minZ = z;
 		vec minId = Zero<vec>();
+		vec minRank = Zero<vec>();
 		vec secondMinX = minX;
 		vec secondMinY = minY;
 		vec secondMinZ = minZ;
 
-		// Loops through moore neighbourhood
-		for (int dz = -1; dz <= 1; dz++) {
-			for (int dy = -1; dy <= 1; dy++) {
-				for (int dx = -1; dx <= 1; dx++) {
+		vec lowerX, upperX, lowerY, upperY, lowerZ, upperZ;
+		CellularEdgeDistance<B, F>(x, lowerX, upperX);
+		CellularEdgeDistance<B, F>(y, lowerY, upperY);
+		CellularEdgeDistance<B, F>(z, lowerZ, upperZ);
 
-					vec gridX = FPAdd<B, F>(x0, dx);
-					vec gridY = FPAdd<B, F>(y0, dy);
-					vec gridZ = FPAdd<B, F>(z0, dz);
-					vec gridhash = Random<B, F>(gridX, gridY, gridZ, seed);
+		for (int k = 0; k < 27; k++) {
+			const int dx = (Feature == 2) ? (k % 3 - 1) : CellularNearestOrder3D[k][0];
+			const int dy = (Feature == 2) ? (k / 3 % 3 - 1) : CellularNearestOrder3D[k][1];
+			const int dz = (Feature == 2) ? (k / 9 - 1) : CellularNearestOrder3D[k][2];
 
-					// Formula to uniformly determines the number of points in a grid cell
-					vec points = And(
-						FPAdd<B, F>(FPMul<B, F>(gridhash, maxPointsPerGrid), 1),
-						fp::IntegerMask
-					);
-					int maxPointCount = fp::FromBase(ReduceMax(points)).ToInt();
-
-					// Loops through each point in the cell
-					for (int i = 0; i < maxPointCount; i++) {
-						vec pointX = FPAdd<B, F>(
-							gridX,
-							Random<B, F>(gridhash, FPBroadcast<B, F>(fpc::Sqrt2), fp::FromBase(i))
-						);
-						vec pointY = FPAdd<B, F>(
-							gridY,
-							Random<B, F>(gridhash, FPBroadcast<B, F>(fpc::Sqrt3), fp::FromBase(i))
-						);
-						vec pointZ = FPAdd<B, F>(gridZ, Random<B, F>(
-							gridhash, FPBroadcast<B, F>(fpc::InvSqrt3), fp::FromBase(i)
-						));
-
-						vec dist = FPAdd<B, F>(
-							FPAdd<B, F>(
-								FPSquare<B, F>(FPSub<B, F>(pointX, x)),
-								FPSquare<B, F>(FPSub<B, F>(pointY, y))
-							),
-							FPSquare<B, F>(FPSub<B, F>(pointZ, z))
-						);
-
-						// Updates the min variables if new point is closest point
-						mask validPointMask = hn::Lt(FPBroadcast<B, F>(i), points);
-						mask isMinMask = hn::Lt(dist, minDist);
-						mask newValueMask = hn::And(isMinMask, validPointMask);
-						minDist = hn::IfThenElse(newValueMask, dist, minDist);
-
-						if constexpr (Feature == 2) {
-							secondMinX = hn::IfThenElse(newValueMask, minX, secondMinX);
-							secondMinY = hn::IfThenElse(newValueMask, minY, secondMinY);
-							secondMinZ = hn::IfThenElse(newValueMask, minZ, secondMinZ);
-						}
+			// Skips the cell if none of its points can be closer
+			vec edgeDist = FPAdd<B, F>(
+				FPAdd<B, F>(
+					CellularEdgeDistance<B, F>(dx, lowerX, upperX),
+					CellularEdgeDistance<B, F>(dy, lowerY, upperY)
+				),
+				CellularEdgeDistance<B, F>(dz, lowerZ, upperZ)
+			);
+			mask isFurther = (Feature == 1) ? hn::Gt(edgeDist, minDist) : hn::Ge(edgeDist, minDist);
 
-						if constexpr (Feature == 1 || Feature == 2) {
-							minX = hn::IfThenElse(newValueMask, pointX, minX);
-							minY = hn::IfThenElse(newValueMask, pointY, minY);
-							minZ = hn::IfThenElse(newValueMask, pointZ, minZ);
-							minId = hn::IfThenElse(newValueMask, Broadcast<vec>(i), minId);
-						}
-					}
+			if (hn::AllTrue(d, isFurther)) {
+				continue;
+			}
+
+			// Position of the cell in scan order
+			const int rank = (dz + 1) * 9 + (dy + 1) * 3 + (dx + 1);
+
+			vec key;
+			vec points = cell(dx, dy, dz, key);
+			int maxPointCount = fp::FromBase(ReduceMax(points)).ToInt();
+
+			// Loops through each point in the cell
+			for (int i = 0; i < maxPointCount; i++) {
+				vec pointX, pointY, pointZ;
+				point(key, dx, dy, dz, i, pointX, pointY, pointZ);
+
+				vec dist = FPAdd<B, F>(
+					FPAdd<B, F>(
+						FPSquare<B, F>(FPSub<B, F>(pointX, x)),
+						FPSquare<B, F>(FPSub<B, F>(pointY, y))
+					),
+					FPSquare<B, F>(FPSub<B, F>(pointZ, z))
+				);
+
+				// Updates the min variables if new point is closest point
+				mask validPointMask = hn::Lt(FPBroadcast<B, F>(i), points);
+				mask isMinMask = hn::Lt(dist, minDist);
+
+				if constexpr (Feature == 1) {
+					isMinMask = hn::Or(isMinMask, hn::And(
+						hn::Eq(dist, minDist), hn::Lt(Broadcast<vec>(rank), minRank)
+					));
+				}
+
+				mask newValueMask = hn::And(isMinMask, validPointMask);
+				minDist = hn::IfThenElse(newValueMask, dist, minDist);
+
+				if constexpr (Feature == 2) {
+					secondMinX = hn::IfThenElse(newValueMask, minX, secondMinX);
+					secondMinY = hn::IfThenElse(newValueMask, minY, secondMinY);
+					secondMinZ = hn::IfThenElse(newValueMask, minZ, secondMinZ);
+				}
+
+				if constexpr (Feature == 1 || Feature == 2) {
+					minX = hn::IfThenElse(newValueMask, pointX, minX);
+					minY = hn::IfThenElse(newValueMask, pointY, minY);
+					minZ = hn::IfThenElse(newValueMask, pointZ, minZ);
+					minId = hn::IfThenElse(newValueMask, Broadcast<vec>(i), minId);
+				}
+
+				if constexpr (Feature == 1) {
+					minRank = hn::IfThenElse(newValueMask, Broadcast<vec>(rank), minRank);
 				}
 			}
 		}
@@ -226,8 +347,293 @@ namespace SIMD::HWY_NAMESPACE
 		}
 	}
 
+	/// <summary>
+	/// Features:
+	/// 0: Return distance to closest cell point
+	/// 1: Return cell's random value
+	/// 2: Return dist between cell's two closest points
+	/// </summary>
+	template <size_t B, size_t F, size_t Feature>
+	inline constexpr auto Cellular(
+		V<B, F> x, V<B, F> y,
+		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid = 1
+	) {
+		using vec = V<B, F>;
+
+		// Grid coordinates
+		vec x0 = FPFloor<B, F>(x);
+		vec y0 = FPFloor<B, F>(y);
+
+		return CellularSearch<B, F, Feature>(x, y, seed,
+			[&](int dx, int dy, vec& gridhash) {
+				gridhash = Random<B, F>(FPAdd<B, F>(x0, dx), FPAdd<B, F>(y0, dy), seed);
+				return CellularPointCount<B, F>(gridhash, maxPointsPerGrid);
+			},
+			[&](vec gridhash, int dx, int dy, int i, vec& pointX, vec& pointY) {
+				CellularPoint<B, F>(
+					gridhash, FPAdd<B, F>(x0, dx), FPAdd<B, F>(y0, dy), i, pointX, pointY
+				);
+			}
+		);
+	}
+
+
+	/// <summary>
+	/// Features:
+	/// 0: Return distance to closest cell point
+	/// 1: Return cell's random value
+	/// 2: Return dist between cell's two closest points
+	/// </summary>
+	template <size_t B, size_t F, size_t Feature>
+	inline constexpr auto Cellular(
+		V<B, F> x, V<B, F> y, V<B, F> z,
+		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid = 1
+	) {
+		using vec = V<B, F>;
+
+		// Grid coordinates
+		vec x0 = FPFloor<B, F>(x);
+		vec y0 = FPFloor<B, F>(y);
+		vec z0 = FPFloor<B, F>(z);
+
+		return CellularSearch<B, F, Feature>(x, y, z, seed,
+			[&](int dx, int dy, int dz, vec& gridhash) {
+				gridhash = Random<B, F>(
+					FPAdd<B, F>(x0, dx), FPAdd<B, F>(y0, dy), FPAdd<B, F>(z0, dz), seed
+				);
+				return CellularPointCount<B, F>(gridhash, maxPointsPerGrid);
+			},
+			[&](
+				vec gridhash, int dx, int dy, int dz, int i,
+				vec& pointX, vec& pointY, vec& pointZ
+			) {
+				CellularPoint<B, F>(
+					gridhash, FPAdd<B, F>(x0, dx), FPAdd<B, F>(y0, dy), FPAdd<B, F>(z0, dz), i,
+					pointX, pointY, pointZ
+				);
+			}
+		);
+	}
+
+	// *********************************************************************************************
+	// CACHE
+	// *********************************************************************************************
+	// Builds the cache of the cells that samples within the bounds search, for Cellular() with the
+	// same seed and maximum number of points. The cache is left invalid if the bounds aren't 2D or
+	// 3D, or it would be larger than CellularCacheMaxValues. It is also left invalid if it has more
+	// cells than sampleCount samples search (sparse samples over large bounds), since hashing the
+	// cells as they are searched is then cheaper. A sampleCount of 0 means it is unknown.
+	template <size_t B, size_t F>
+	inline void GetCellularCache(
+		const std::vector<NoiseSamplingBound<B, F>>& bounds,
+		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid, int64_t sampleCount,
+		CellularCache<B, F>& cache
+	) {
+		using vec = V<B, F>;
+		using fp = FixedPoint<B, F>;
+		const D<B, F> d;
+		const int lanes = int(hn::Lanes(d));
+
+		cache.IsValid = false;
+		cache.Dimensions = int(bounds.size());
+
+		if (cache.Dimensions < 2 || cache.Dimensions > 3) {
+			return;
+		}
+
+		// Cells have at most maxPointsPerGrid points, and always at least 1.
+		const int maxPoints = std::max(int(maxPointsPerGrid), 1);
+		cache.Stride = 1 + maxPoints * cache.Dimensions;
+
+		int64_t values = cache.Stride;
+		int64_t cells = 1;
+
+		for (int a = 0; a < 3; ++a) {
+			if (a < cache.Dimensions) {
+				// The cells of the bounds, and their neighbours.
+				const int64_t begin = int64_t(bounds[a].Start.ToRaw() >> F) - 1;
+				const int64_t end = int64_t(bounds[a].End.ToRaw() >> F) + 1;
+
+				if (end < begin) {
+					return;
+				}
+
+				cache.Begin[a] = int(begin);
+				cache.Size[a] = int(end - begin + 1);
+			}
+			else {
+				cache.Begin[a] = 0;
+				cache.Size[a] = 1;
+			}
+
+			values *= cache.Size[a];
+			cells *= cache.Size[a];
+
+			if (values > CellularCacheMaxValues) {
+				return;
+			}
+		}
+
+		// Each sample searches its moore neighbourhood of 3^dimensions cells.
+		const int64_t neighbourhood = (cache.Dimensions == 2) ? 9 : 27;
+
+		if (sampleCount > 0 && cells > sampleCount * neighbourhood) {
+			return;
+		}
+
+		// Rows are written a vector at a time, so the last vector of a row spills into the next
+		// row, which overwrites it. The last row spills into the padding.
+		cache.Values.EnsureSize(int(values) + lanes * cache.Stride);
+		T<B, F>* ptr = cache.Values.GetPtr();
+		const vec scatter = sn::Mul(hn::Iota(d, 0), cache.Stride);
+
+		for (int iz = 0; iz < cache.Size[2]; ++iz) {
+			const vec gridZ = FPBroadcast<B, F>(fp(cache.Begin[2] + iz));
+
+			for (int iy = 0; iy < cache.Size[1]; ++iy) {
+				const vec gridY = FPBroadcast<B, F>(fp(cache.Begin[1] + iy));
+				T<B, F>* row = ptr +
+					(int64_t(iz) * cache.Size[1] + iy) * cache.Size[0] * cache.Stride;
+
+				for (int ix = 0; ix < cache.Size[0]; ix += lanes) {
+					const vec gridX = hn::ShiftLeft<F>(hn::Iota(d, cache.Begin[0] + ix));
+					T<B, F>* cell = row + ix * cache.Stride;
+
+					const vec gridhash = (cache.Dimensions == 2) ?
+						Random<B, F>(gridX, gridY, seed) :
+						Random<B, F>(gridX, gridY, gridZ, seed);
+
+					hn::ScatterIndex(
+						CellularPointCount<B, F>(gridhash, maxPointsPerGrid), d, cell, scatter
+					);
+
+					for (int i = 0; i < maxPoints; ++i) {
+						T<B, F>* point = cell + 1 + i * cache.Dimensions;
+
+						if (cache.Dimensions == 2) {
+							vec pointX, pointY;
+							CellularPoint<B, F>(gridhash, gridX, gridY, i, pointX, pointY);
+							hn::ScatterIndex(pointX, d, point + 0, scatter);
+							hn::ScatterIndex(pointY, d, point + 1, scatter);
+						}
+						else {
+							vec pointX, pointY, pointZ;
+							CellularPoint<B, F>(
+								gridhash, gridX, gridY, gridZ, i, pointX, pointY, pointZ
+							);
+							hn::ScatterIndex(pointX, d, point + 0, scatter);
+							hn::ScatterIndex(pointY, d, point + 1, scatter);
+							hn::ScatterIndex(pointZ, d, point + 2, scatter);
+						}
+					}
+				}
+			}
+		}
+
+		cache.IsValid = true;
+	}
+
+	// Index of the samples' cells on an axis of the cache. Returns false if any of their
+	// neighbours on that axis isn't cached.
+	template <size_t B, size_t F>
+	HWY_INLINE bool GetCellularCacheAxis(
+		V<B, F> grid, const CellularCache<B, F>& cache, int axis, V<B, F>& index
+	) {
+		const D<B, F> d;
+		index = hn::Sub(hn::ShiftRight<F>(grid), hn::Set(d, cache.Begin[axis]));
+		return hn::AllTrue(d, hn::And(
+			hn::Gt(index, hn::Zero(d)), hn::Lt(index, hn::Set(d, cache.Size[axis] - 1))
+		));
+	}
+
+	// Same as Cellular(), with the points loaded from a cache built with the same seed and
+	// maximum number of points. Vectors with samples outside of the cache are hashed as usual.
+	template <size_t B, size_t F, size_t Feature>
+	inline auto Cellular(
+		V<B, F> x, V<B, F> y,
+		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid, const CellularCache<B, F>& cache
+	) {
+		using vec = V<B, F>;
+		const D<B, F> d;
 
+		// Grid coordinates
+		vec x0 = FPFloor<B, F>(x);
+		vec y0 = FPFloor<B, F>(y);
 
+		vec ix, iy;
+		if (cache.Dimensions != 2 ||
+			!GetCellularCacheAxis<B, F>(x0, cache, 0, ix) ||
+			!GetCellularCacheAxis<B, F>(y0, cache, 1, iy)
+		) {
+			return Cellular<B, F, Feature>(x, y, seed, maxPointsPerGrid);
+		}
+
+		const int stride = cache.Stride;
+		const int strideY = cache.Size[0] * stride;
+		const T<B, F>* values = cache.Values.GetPtr();
+		const vec center = hn::Add(sn::Mul(ix, stride), sn::Mul(iy, strideY));
+
+		return CellularSearch<B, F, Feature>(x, y, seed,
+			[&](int dx, int dy, vec& cell) {
+				cell = hn::Add(center, hn::Set(d, dx * stride + dy * strideY));
+				return hn::GatherIndex(d, values, cell);
+			},
+			[&](vec cell, int dx, int dy, int i, vec& pointX, vec& pointY) {
+				const T<B, F>* point = values + 1 + i * 2;
+				pointX = hn::GatherIndex(d, point + 0, cell);
+				pointY = hn::GatherIndex(d, point + 1, cell);
+			}
+		);
+	}
+
+	// Same as Cellular(), with the points loaded from a cache built with the same seed and
+	// maximum number of points. Vectors with samples outside of the cache are hashed as usual.
+	template <size_t B, size_t F, size_t Feature>
+	inline auto Cellular(
+		V<B, F> x, V<B, F> y, V<B, F> z,
+		FixedPoint<B, F> seed, unsigned int maxPointsPerGrid, const CellularCache<B, F>& cache
+	) {
+		using vec = V<B, F>;
+		const D<B, F> d;
+
+		// Grid coordinates
+		vec x0 = FPFloor<B, F>(x);
+		vec y0 = FPFloor<B, F>(y);
+		vec z0 = FPFloor<B, F>(z);
+
+		vec ix, iy, iz;
+		if (cache.Dimensions != 3 ||
+			!GetCellularCacheAxis<B, F>(x0, cache, 0, ix) ||
+			!GetCellularCacheAxis<B, F>(y0, cache, 1, iy) ||
+			!GetCellularCacheAxis<B, F>(z0, cache, 2, iz)
+		) {
+			return Cellular<B, F, Feature>(x, y, z, seed, maxPointsPerGrid);
+		}
+
+		const int stride = cache.Stride;
+		const int strideY = cache.Size[0] * stride;
+		const int strideZ = cache.Size[1] * strideY;
+		const T<B, F>* values = cache.Values.GetPtr();
+		const vec center = hn::Add(
+			hn::Add(sn::Mul(ix, stride), sn::Mul(iy, strideY)), sn::Mul(iz, strideZ)
+		);
+
+		return CellularSearch<B, F, Feature>(x, y, z, seed,
+			[&](int dx, int dy, int dz, vec& cell) {
+				cell = hn::Add(center, hn::Set(d, dx * stride + dy * strideY + dz * strideZ));
+				return hn::GatherIndex(d, values, cell);
+			},
+			[&](
+				vec cell, int dx, int dy, int dz, int i,
+				vec& pointX, vec& pointY, vec& pointZ
+			) {
+				const T<B, F>* point = values + 1 + i * 3;
+				pointX = hn::GatherIndex(d, point + 0, cell);
+				pointY = hn::GatherIndex(d, point + 1, cell);
+				pointZ = hn::GatherIndex(d, point + 2, cell);
+			}
+		);
+	}
 }
 HWY_AFTER_NAMESPACE();
 
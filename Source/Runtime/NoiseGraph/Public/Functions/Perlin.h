@@ -15,110 +15,108 @@
 #include "Numerics/FixedPoint.h"
 #include "Numerics/FixedPointConstants.h"
 #include "Numerics/FixedPointSIMD.h"
-#include "Random.h"
+#include "Cryptography/HashSIMD.h"
+#include "NoiseRange.h"
 
 #include "Diagnostics/DebugLog.h"
 
 HWY_BEFORE_NAMESPACE();
 namespace SIMD::HWY_NAMESPACE
 {
+	// Dot product of the offset from a corner (dx, dy) with the corner's gradient, picked by the
+	// 4 lowest bits of its hash. Gradients are stored per component, 16 to a table, so that
+	// they're looked up in registers rather than gathered.
 	template <size_t B, size_t F>
-	inline constexpr V<B, F> PerlinDotGradient(
-		V<B, F> x, V<B, F> y, 
-		V<B, F> ix, V<B, F> iy, FixedPoint<B, F> seed
-	) {
+	HWY_INLINE constexpr V<B, F> PerlinDotGradient(V<B, F> hash, V<B, F> dx, V<B, F> dy) {
 		using vec = V<B, F>;
 		using fpc = FixedPointConstant<B, F>;
 
-		HWY_ALIGN static std::array<T<B, F>, 32> unitTable = {
-			// Cardinals
-			fpc::One.ToRaw(),						0,										// 0
-			0,										fpc::One.ToRaw(),						// 90
-			-fpc::One.ToRaw(),						0,										// 180
-			0,										-fpc::One.ToRaw(),						// 270
-
-			// Diagonals
-			(fpc::Sqrt2 >> 1).ToRaw(),				(fpc::Sqrt2 >> 1).ToRaw(),				// 45
-			-(fpc::Sqrt2 >> 1).ToRaw(),				(fpc::Sqrt2 >> 1).ToRaw(),				// 135
-			-(fpc::Sqrt2 >> 1).ToRaw(),				-(fpc::Sqrt2 >> 1).ToRaw(),				// 225
-			(fpc::Sqrt2 >> 1).ToRaw(),				-(fpc::Sqrt2 >> 1).ToRaw(),				// 315
-
-			// 22.5 Degree Increments
-			(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),		(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),		// 22.5
-			(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),		(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),		// 67.5
-			-(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),	(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),		// 112.5
-			-(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),	(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),		// 157.5
-			-(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),	-(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),	// 202.5
-			-(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),	-(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),	// 247.5
-			(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw(),		-(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),	// 292.5
-			(fpc::Sqrt_2AddSqrt2 >> 1).ToRaw(),		-(fpc::Sqrt_2SubSqrt2 >> 1).ToRaw()		// 337.5
+		constexpr T<B, F> One = fpc::One.ToRaw();
+		constexpr T<B, F> Diagonal = (fpc::Sqrt2 >> 1).ToRaw();
+		constexpr T<B, F> Major = (fpc::Sqrt_2AddSqrt2 >> 1).ToRaw();	// cos(22.5)
+		constexpr T<B, F> Minor = (fpc::Sqrt_2SubSqrt2 >> 1).ToRaw();	// sin(22.5)
+
+		// Cardinals (from 0), diagonals (from 45), then 22.5 degree increments (from 22.5)
+		HWY_ALIGN static constexpr T<B, F> gradientsX[16] = {
+			One,		0,			-One,		0,
+			Diagonal,	-Diagonal,	-Diagonal,	Diagonal,
+			Major,		Minor,		-Minor,		-Major,
+			-Major,		-Minor,		Minor,		Major
+		};
+		HWY_ALIGN static constexpr T<B, F> gradientsY[16] = {
+			0,			One,		0,			-One,
+			Diagonal,	Diagonal,	-Diagonal,	-Diagonal,
+			Minor,		Major,		Major,		Minor,
+			-Minor,		-Major,		-Major,		-Minor
 		};
 
 		const D<B, F> d;
 
-		vec deltaX = FPSub<B, F>(x, ix);
-		vec deltaY = FPSub<B, F>(y, iy);
 		// Non-FP operations for index. We want to keep the rightmost 4 bits (For up to 16 digits)
-		vec idx = hn::ShiftLeft<1>(And(Random<B, F>(ix, iy, seed.ToRaw()), 15));
-		vec gradX = hn::GatherIndex(d, unitTable.data(), idx);
-		vec gradY = hn::GatherIndex(d, unitTable.data(), Add(idx, 1));
+		vec idx = And(hash, 15);
+		vec gradX = TableLookup<16>(d, gradientsX, idx);
+		vec gradY = TableLookup<16>(d, gradientsY, idx);
 
 		return FPAdd<B, F>(
-			FPMul<B, F>(deltaX, gradX),
-			FPMul<B, F>(deltaY, gradY)
+			FPMul<B, F>(dx, gradX),
+			FPMul<B, F>(dy, gradY)
 		);
 	}
 
+	// Same as the 2D version, with the 12 cube edge directions and 4 of its diagonals.
 	template <size_t B, size_t F>
-	inline constexpr V<B, F> PerlinDotGradient(
-		V<B, F> x, V<B, F> y, V<B, F> z,
-		V<B, F> ix, V<B, F> iy, V<B, F> iz, FixedPoint<B, F> seed) {
+	HWY_INLINE constexpr V<B, F> PerlinDotGradient(
+		V<B, F> hash, V<B, F> dx, V<B, F> dy, V<B, F> dz
+	) {
 		using vec = V<B, F>;
 		using fpc = FixedPointConstant<B, F>;
 
-		HWY_ALIGN static std::array<T<B, F>, 48> unitTable = {
-			fpc::InvSqrt2.ToRaw(),	fpc::InvSqrt2.ToRaw(),	0,
-			fpc::InvSqrt2.ToRaw(),	-fpc::InvSqrt2.ToRaw(),	0,
-			-fpc::InvSqrt2.ToRaw(),	fpc::InvSqrt2.ToRaw(),	0,
-			-fpc::InvSqrt2.ToRaw(),	-fpc::InvSqrt2.ToRaw(),	0,
-
-			fpc::InvSqrt2.ToRaw(),	0,						fpc::InvSqrt2.ToRaw(),
-			fpc::InvSqrt2.ToRaw(),	0,						-fpc::InvSqrt2.ToRaw(),
-			-fpc::InvSqrt2.ToRaw(),	0,						fpc::InvSqrt2.ToRaw(),
-			-fpc::InvSqrt2.ToRaw(),	0,						-fpc::InvSqrt2.ToRaw(),
-
-			0,						fpc::InvSqrt2.ToRaw(),	fpc::InvSqrt2.ToRaw(),
-			0,						fpc::InvSqrt2.ToRaw(),	-fpc::InvSqrt2.ToRaw(),
-			0,						-fpc::InvSqrt2.ToRaw(),	fpc::InvSqrt2.ToRaw(),
-			0,						-fpc::InvSqrt2.ToRaw(),	-fpc::InvSqrt2.ToRaw(),
-
-			fpc::InvSqrt3.ToRaw(),	fpc::InvSqrt3.ToRaw(),	fpc::InvSqrt3.ToRaw(),
-			fpc::InvSqrt3.ToRaw(),	fpc::InvSqrt3.ToRaw(),	-fpc::InvSqrt3.ToRaw(),
-			fpc::InvSqrt3.ToRaw(),	-fpc::InvSqrt3.ToRaw(),	fpc::InvSqrt3.ToRaw(),
-			-fpc::InvSqrt3.ToRaw(),	fpc::InvSqrt3.ToRaw(),	fpc::InvSqrt3.ToRaw()
+		constexpr T<B, F> Edge = fpc::InvSqrt2.ToRaw();
+		constexpr T<B, F> Diagonal = fpc::InvSqrt3.ToRaw();
+
+		HWY_ALIGN static constexpr T<B, F> gradientsX[16] = {
+			Edge,		Edge,		-Edge,		-Edge,
+			Edge,		Edge,		-Edge,		-Edge,
+			0,			0,			0,			0,
+			Diagonal,	Diagonal,	Diagonal,	-Diagonal
+		};
+		HWY_ALIGN static constexpr T<B, F> gradientsY[16] = {
+			Edge,		-Edge,		Edge,		-Edge,
+			0,			0,			0,			0,
+			Edge,		Edge,		-Edge,		-Edge,
+			Diagonal,	Diagonal,	-Diagonal,	Diagonal
+		};
+		HWY_ALIGN static constexpr T<B, F> gradientsZ[16] = {
+			0,			0,			0,			0,
+			Edge,		-Edge,		Edge,		-Edge,
+			Edge,		-Edge,		Edge,		-Edge,
+			Diagonal,	-Diagonal,	Diagonal,	Diagonal
 		};
 
 		const D<B, F> d;
 
-		vec deltaX = FPSub<B, F>(x, ix);
-		vec deltaY = FPSub<B, F>(y, iy);
-		vec deltaZ = FPSub<B, F>(z, iz);
-
 		// Non-FP operations for index. We want to keep the rightmost 4 bits (For up to 16 digits)
-		vec idx = Mul(And(Random<B, F>(ix, iy, iz, seed.ToRaw()), 15), 3);
-		vec gradX = hn::GatherIndex(d, unitTable.data(), idx);
-		vec gradY = hn::GatherIndex(d, unitTable.data(), Add(idx, 1));
-		vec gradZ = hn::GatherIndex(d, unitTable.data(), Add(idx, 2));
+		vec idx = And(hash, 15);
+		vec gradX = TableLookup<16>(d, gradientsX, idx);
+		vec gradY = TableLookup<16>(d, gradientsY, idx);
+		vec gradZ = TableLookup<16>(d, gradientsZ, idx);
 
 		return FPAdd<B, F>(
 			FPAdd<B, F>(
-				FPMul<B, F>(deltaX, gradX),
-				FPMul<B, F>(deltaY, gradY)
+				FPMul<B, F>(dx, gradX),
+				FPMul<B, F>(dy, gradY)
 			), 
-			FPMul<B, F>(deltaZ, gradZ)
+			FPMul<B, F>(dz, gradZ)
 		);
 	}
 
+	// Hash of a corner from the hash terms of its coordinates (see HashTerm()). Same as
+	// Random(ix, iy[, iz], seed), without the fraction mask, which keeps the lowest bits anyway.
+	template <size_t B, size_t F>
+	HWY_INLINE constexpr V<B, F> PerlinCornerHash(UV<B, F> terms) {
+		return Reinterpret<V<B, F>>(Scramble(terms));
+	}
+
 	// Equivalent to:
 	// t3 * ((6 * t2) - (15 * t) + 10)
 	template <size_t B, size_t F>
@@ -138,24 +136,52 @@ namespace SIMD::HWY_NAMESPACE
 		);
 	}
 
+	// Lattice values of a coordinate, which only depend on that coordinate. They're shared by
+	// every sample in the same row or column of a grid (see NoiseProgramGrid): the hash terms
+	// of the lower and upper corners, the offsets from them, and the fade.
+	//
+	// Count and Index are those of the coordinate's HashTerm(). seedTerm is added to the hash
+	// terms, and is zero except for the axis that carries the seed (see PerlinSeedTerm()).
+	template <size_t B, size_t F, size_t Count, size_t Index>
+	HWY_INLINE constexpr void GetPerlinAxis(
+		V<B, F> c, UV<B, F> seedTerm,
+		UV<B, F>& hash0, UV<B, F>& hash1, V<B, F>& delta0, V<B, F>& delta1, V<B, F>& fade
+	) {
+		using vec = V<B, F>;
+		using uvec = UV<B, F>;
+
+		vec c0 = FPFloor<B, F>(c);
+		vec c1 = FPAdd<B, F>(c0, 1);
+
+		hash0 = hn::Add(HashTerm<Count, Index>(Reinterpret<uvec>(c0)), seedTerm);
+		hash1 = hn::Add(HashTerm<Count, Index>(Reinterpret<uvec>(c1)), seedTerm);
+		delta0 = FPSub<B, F>(c, c0);
+		delta1 = FPSub<B, F>(c, c1);
+		fade = PerlinFade<B, F>(c - c0);
+	}
+
+	// Hash term of the seed, which is the last input of the corner hashes.
+	template <size_t B, size_t F, size_t Count>
+	HWY_INLINE constexpr UV<B, F> PerlinSeedTerm(FixedPoint<B, F> seed) {
+		const FixedPoint<B, F> hashSeed = seed.ToRaw();
+		return HashTerm<Count, Count - 1>(Broadcast<UV<B, F>>(hashSeed.ToRaw()));
+	}
+
+	// Perlin() from the lattice values of its coordinates (see GetPerlinAxis()).
 	template <size_t B, size_t F>
-	inline constexpr V<B, F> Perlin(V<B, F> x, V<B, F> y, FixedPoint<B, F> seed) {
+	HWY_INLINE constexpr V<B, F> PerlinFromAxes(
+		UV<B, F> hx0, UV<B, F> hx1, V<B, F> dx0, V<B, F> dx1, V<B, F> xf,
+		UV<B, F> hy0, UV<B, F> hy1, V<B, F> dy0, V<B, F> dy1, V<B, F> yf
+	) {
 		using vec = V<B, F>;
-		// Grid coordinates
-		vec x0 = FPFloor<B, F>(x);
-		vec y0 = FPFloor<B, F>(y);
-		vec x1 = FPAdd<B, F>(x0, 1);
-		vec y1 = FPAdd<B, F>(y0, 1);
 
 		// Dot products
-		vec d00 = PerlinDotGradient<B, F>(x, y, x0, y0, seed);
-		vec d01 = PerlinDotGradient<B, F>(x, y, x0, y1, seed);
-		vec d10 = PerlinDotGradient<B, F>(x, y, x1, y0, seed);
-		vec d11 = PerlinDotGradient<B, F>(x, y, x1, y1, seed);
+		vec d00 = PerlinDotGradient<B, F>(PerlinCornerHash<B, F>(hn::Add(hx0, hy0)), dx0, dy0);
+		vec d01 = PerlinDotGradient<B, F>(PerlinCornerHash<B, F>(hn::Add(hx0, hy1)), dx0, dy1);
+		vec d10 = PerlinDotGradient<B, F>(PerlinCornerHash<B, F>(hn::Add(hx1, hy0)), dx1, dy0);
+		vec d11 = PerlinDotGradient<B, F>(PerlinCornerHash<B, F>(hn::Add(hx1, hy1)), dx1, dy1);
 
 		// Fade lerps
-		vec xf = PerlinFade<B, F>(x - x0);
-		vec yf = PerlinFade<B, F>(y - y0);
 		vec d0010 = FPLerp<B, F>(d00, d10, xf);
 		vec d0111 = FPLerp<B, F>(d01, d11, xf);
 
@@ -167,33 +193,36 @@ namespace SIMD::HWY_NAMESPACE
 	}
 
 	template <size_t B, size_t F>
-	inline constexpr V<B, F> Perlin(
-		V<B, F> x, V<B, F> y, V<B, F> z, FixedPoint<B, F> seed
+	HWY_INLINE constexpr V<B, F> PerlinFromAxes(
+		UV<B, F> hx0, UV<B, F> hx1, V<B, F> dx0, V<B, F> dx1, V<B, F> xf,
+		UV<B, F> hy0, UV<B, F> hy1, V<B, F> dy0, V<B, F> dy1, V<B, F> yf,
+		UV<B, F> hz0, UV<B, F> hz1, V<B, F> dz0, V<B, F> dz1, V<B, F> zf
 	) {
 		using vec = V<B, F>;
+		using uvec = UV<B, F>;
 
-		// Grid coordinates
-		vec x0 = FPFloor<B, F>(x);
-		vec y0 = FPFloor<B, F>(y);
-		vec z0 = FPFloor<B, F>(z);
-		vec x1 = FPAdd<B, F>(x0, 1);
-		vec y1 = FPAdd<B, F>(y0, 1);
-		vec z1 = FPAdd<B, F>(z0, 1);
+		uvec hx0y0 = hn::Add(hx0, hy0);
+		uvec hx0y1 = hn::Add(hx0, hy1);
+		uvec hx1y0 = hn::Add(hx1, hy0);
+		uvec hx1y1 = hn::Add(hx1, hy1);
 
 		// Dot products
-		vec d000 = PerlinDotGradient<B, F>(x, y, z, x0, y0, z0, seed);
-		vec d001 = PerlinDotGradient<B, F>(x, y, z, x0, y0, z1, seed);
-		vec d010 = PerlinDotGradient<B, F>(x, y, z, x0, y1, z0, seed);
-		vec d011 = PerlinDotGradient<B, F>(x, y, z, x0, y1, z1, seed);
-		vec d100 = PerlinDotGradient<B, F>(x, y, z, x1, y0, z0, seed);
-		vec d101 = PerlinDotGradient<B, F>(x, y, z, x1, y0, z1, seed);
-		vec d110 = PerlinDotGradient<B, F>(x, y, z, x1, y1, z0, seed);
-		vec d111 = PerlinDotGradient<B, F>(x, y, z, x1, y1, z1, seed);
-
-		// Fade lerps
-		vec xf = PerlinFade<B, F>(x - x0);
-		vec yf = PerlinFade<B, F>(y - y0);
-		vec zf = PerlinFade<B, F>(z - z0);
+		vec d000 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx0y0, hz0)), dx0, dy0, dz0);
+		vec d001 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx0y0, hz1)), dx0, dy0, dz1);
+		vec d010 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx0y1, hz0)), dx0, dy1, dz0);
+		vec d011 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx0y1, hz1)), dx0, dy1, dz1);
+		vec d100 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx1y0, hz0)), dx1, dy0, dz0);
+		vec d101 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx1y0, hz1)), dx1, dy0, dz1);
+		vec d110 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx1y1, hz0)), dx1, dy1, dz0);
+		vec d111 = PerlinDotGradient<B, F>(
+			PerlinCornerHash<B, F>(hn::Add(hx1y1, hz1)), dx1, dy1, dz1);
 
 		// Interpolate in x-direction
 		vec d000100 = FPLerp<B, F>(d000, d100, xf);
@@ -211,6 +240,56 @@ namespace SIMD::HWY_NAMESPACE
 		result = FPMul<B, F>(result, FixedPointConstant<B, F>::Sqrt3); // Scaling to [-1, 1]
 		return hn::ShiftRight<1>(FPAdd<B, F>(result, 1)); // to [0, 1]
 	}
+
+	// Range of Perlin() in some number of dimensions. Gradients are unit length, so the noise
+	// reaches sqrt(N / 4) before it is scaled. 2D is scaled to [0, 1], but 3D is scaled by sqrt(3)
+	// rather than 2 / sqrt(3), so it's within [-0.25, 1.25]. Widened by a few units for rounding.
+	template <size_t B, size_t F>
+	inline NoiseRange<B, F> GetPerlinRange(size_t dimensions) {
+		using fp = FixedPoint<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+
+		const NoiseRange<B, F> range = (dimensions >= 3) ?
+			NoiseRange<B, F>{ -(fpc::One >> 2), fpc::One + (fpc::One >> 2) } :
+			NoiseRange<B, F>::Unit();
+
+		return range.Widen(fp::FromBase(4));
+	}
+
+	// The seed is added to y's hash terms.
+	template <size_t B, size_t F>
+	inline constexpr V<B, F> Perlin(V<B, F> x, V<B, F> y, FixedPoint<B, F> seed) {
+		using vec = V<B, F>;
+		using uvec = UV<B, F>;
+
+		uvec hx0, hx1, hy0, hy1;
+		vec dx0, dx1, dy0, dy1, xf, yf;
+		GetPerlinAxis<B, F, 3, 0>(x, Zero<uvec>(), hx0, hx1, dx0, dx1, xf);
+		GetPerlinAxis<B, F, 3, 1>(y, PerlinSeedTerm<B, F, 3>(seed), hy0, hy1, dy0, dy1, yf);
+
+		return PerlinFromAxes<B, F>(hx0, hx1, dx0, dx1, xf, hy0, hy1, dy0, dy1, yf);
+	}
+
+	// The seed is added to z's hash terms.
+	template <size_t B, size_t F>
+	inline constexpr V<B, F> Perlin(
+		V<B, F> x, V<B, F> y, V<B, F> z, FixedPoint<B, F> seed
+	) {
+		using vec = V<B, F>;
+		using uvec = UV<B, F>;
+
+		uvec hx0, hx1, hy0, hy1, hz0, hz1;
+		vec dx0, dx1, dy0, dy1, dz0, dz1, xf, yf, zf;
+		GetPerlinAxis<B, F, 4, 0>(x, Zero<uvec>(), hx0, hx1, dx0, dx1, xf);
+		GetPerlinAxis<B, F, 4, 1>(y, Zero<uvec>(), hy0, hy1, dy0, dy1, yf);
+		GetPerlinAxis<B, F, 4, 2>(z, PerlinSeedTerm<B, F, 4>(seed), hz0, hz1, dz0, dz1, zf);
+
+		return PerlinFromAxes<B, F>(
+			hx0, hx1, dx0, dx1, xf,
+			hy0, hy1, dy0, dy1, yf,
+			hz0, hz1, dz0, dz1, zf
+		);
+	}
 }
 HWY_AFTER_NAMESPACE();
 
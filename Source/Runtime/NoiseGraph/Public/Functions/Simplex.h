@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_FUNCTIONS_SIMPLEX_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_FUNCTIONS_SIMPLEX_SIMD_H_
+#undef NOISEGRAPH_FUNCTIONS_SIMPLEX_SIMD_H_
+#else
+#define NOISEGRAPH_FUNCTIONS_SIMPLEX_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+
+#include "OperationsSIMD.h"
+#include "Numerics/FixedPoint.h"
+#include "Numerics/FixedPointConstants.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "Random.h"
+#include "Perlin.h"
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Simplex noise, in the style of OpenSimplex2: the lattice is skewed into triangles (2D) or
+	// tetrahedrons (3D), so that only 3 or 4 corners contribute to each sample, rather than the
+	// 4 or 8 of Perlin. Corners use the same gradients as Perlin, and a radius of sqrt(0.5),
+	// which keeps the noise continuous in 3D.
+
+	// Contribution of a corner at offset (dx, dy) from the sample.
+	// The falloff is (2 * (0.5 - d^2))^4 = (1 - 2 * d^2)^4, which stays in [0, 1] so that it
+	// keeps its precision in fixed point. It's 16 times the usual (0.5 - d^2)^4.
+	template <size_t B, size_t F>
+	inline constexpr V<B, F> SimplexCorner(
+		V<B, F> dx, V<B, F> dy, V<B, F> ix, V<B, F> iy, FixedPoint<B, F> seed
+	) {
+		using vec = V<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+
+		vec falloff = FPSub<B, F>(
+			fpc::One, hn::ShiftLeft<1>(FPAdd<B, F>(FPSquare<B, F>(dx), FPSquare<B, F>(dy))));
+		falloff = hn::ZeroIfNegative(falloff);
+		falloff = FPSquare<B, F>(FPSquare<B, F>(falloff));
+
+		// Same gradients as Perlin
+		return FPMul<B, F>(
+			falloff, PerlinDotGradient<B, F>(Random<B, F>(ix, iy, seed), dx, dy));
+	}
+
+	template <size_t B, size_t F>
+	inline constexpr V<B, F> SimplexCorner(
+		V<B, F> dx, V<B, F> dy, V<B, F> dz,
+		V<B, F> ix, V<B, F> iy, V<B, F> iz, FixedPoint<B, F> seed
+	) {
+		using vec = V<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+
+		vec falloff = FPSub<B, F>(
+			fpc::One,
+			hn::ShiftLeft<1>(FPAdd<B, F>(
+				FPAdd<B, F>(FPSquare<B, F>(dx), FPSquare<B, F>(dy)), FPSquare<B, F>(dz)))
+		);
+		falloff = hn::ZeroIfNegative(falloff);
+		falloff = FPSquare<B, F>(FPSquare<B, F>(falloff));
+
+		// Same gradients as Perlin
+		return FPMul<B, F>(
+			falloff, PerlinDotGradient<B, F>(Random<B, F>(ix, iy, iz, seed), dx, dy, dz));
+	}
+
+	template <size_t B, size_t F>
+	inline constexpr V<B, F> Simplex(V<B, F> x, V<B, F> y, FixedPoint<B, F> seed) {
+		using fp = FixedPoint<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+		using vec = V<B, F>;
+
+		// Skew (sqrt(3) - 1) / 2 and unskew (3 - sqrt(3)) / 6 factors
+		const fp skew = (fpc::Sqrt3 - fpc::One) >> 1;
+		const fp unskew = (fp(3) - fpc::Sqrt3) / fp(6);
+
+		// Corner of the skewed cell, and the offset from it in unskewed space
+		vec s = FPMul<B, F>(FPAdd<B, F>(x, y), skew);
+		vec i = FPFloor<B, F>(FPAdd<B, F>(x, s));
+		vec j = FPFloor<B, F>(FPAdd<B, F>(y, s));
+		vec t = FPMul<B, F>(FPAdd<B, F>(i, j), unskew);
+		vec x0 = FPSub<B, F>(x, FPSub<B, F>(i, t));
+		vec y0 = FPSub<B, F>(y, FPSub<B, F>(j, t));
+
+		// The middle corner of the triangle is along the larger offset.
+		auto isXLarger = hn::Gt(x0, y0);
+		vec i1 = hn::IfThenElseZero(isXLarger, FPBroadcast<B, F>(fpc::One));
+		vec j1 = hn::IfThenZeroElse(isXLarger, FPBroadcast<B, F>(fpc::One));
+
+		vec x1 = FPAdd<B, F>(FPSub<B, F>(x0, i1), unskew);
+		vec y1 = FPAdd<B, F>(FPSub<B, F>(y0, j1), unskew);
+		vec x2 = FPAdd<B, F>(x0, (unskew << 1) - fpc::One);
+		vec y2 = FPAdd<B, F>(y0, (unskew << 1) - fpc::One);
+
+		vec result = FPAdd<B, F>(
+			FPAdd<B, F>(
+				SimplexCorner<B, F>(x0, y0, i, j, seed),
+				SimplexCorner<B, F>(x1, y1, FPAdd<B, F>(i, i1), FPAdd<B, F>(j, j1), seed)
+			),
+			SimplexCorner<B, F>(x2, y2, FPAdd<B, F>(i, 1), FPAdd<B, F>(j, 1), seed)
+		);
+
+		// The sum falls in [-1 / 6.2, 1 / 6.2] (found numerically, with the 16x falloff).
+		// Scaling to [-0.5, 0.5], then shifting to [0, 1]. Clamped for rounding.
+		result = FPAdd<B, F>(FPMul<B, F>(result, fp(3.1)), fpc::One >> 1);
+		return FPClamp<B, F>(result, fp(0), fpc::One);
+	}
+
+	template <size_t B, size_t F>
+	inline constexpr V<B, F> Simplex(
+		V<B, F> x, V<B, F> y, V<B, F> z, FixedPoint<B, F> seed
+	) {
+		using fp = FixedPoint<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+		using vec = V<B, F>;
+
+		// Skew 1/3 and unskew 1/6 factors
+		const fp skew = fpc::One / fp(3);
+		const fp unskew = fpc::One / fp(6);
+		const vec one = FPBroadcast<B, F>(fpc::One);
+
+		// Corner of the skewed cell, and the offset from it in unskewed space
+		vec s = FPMul<B, F>(FPAdd<B, F>(FPAdd<B, F>(x, y), z), skew);
+		vec i = FPFloor<B, F>(FPAdd<B, F>(x, s));
+		vec j = FPFloor<B, F>(FPAdd<B, F>(y, s));
+		vec k = FPFloor<B, F>(FPAdd<B, F>(z, s));
+		vec t = FPMul<B, F>(FPAdd<B, F>(FPAdd<B, F>(i, j), k), unskew);
+		vec x0 = FPSub<B, F>(x, FPSub<B, F>(i, t));
+		vec y0 = FPSub<B, F>(y, FPSub<B, F>(j, t));
+		vec z0 = FPSub<B, F>(z, FPSub<B, F>(k, t));
+
+		// The tetrahedron's corners step along the axes from the largest offset to the smallest.
+		// Ties are broken so that the second corner is always one step away, and the third two.
+		auto xy = hn::Ge(x0, y0);
+		auto yz = hn::Ge(y0, z0);
+		auto xz = hn::Ge(x0, z0);
+
+		vec i1 = hn::IfThenElseZero(hn::And(xy, xz), one);
+		vec j1 = hn::IfThenElseZero(hn::AndNot(xy, yz), one);
+		vec k1 = hn::IfThenZeroElse(hn::Or(yz, xz), one);
+		vec i2 = hn::IfThenElseZero(hn::Or(xy, xz), one);
+		vec j2 = hn::IfThenZeroElse(hn::AndNot(yz, xy), one);
+		vec k2 = hn::IfThenZeroElse(hn::And(yz, xz), one);
+
+		vec x1 = FPAdd<B, F>(FPSub<B, F>(x0, i1), unskew);
+		vec y1 = FPAdd<B, F>(FPSub<B, F>(y0, j1), unskew);
+		vec z1 = FPAdd<B, F>(FPSub<B, F>(z0, k1), unskew);
+		vec x2 = FPAdd<B, F>(FPSub<B, F>(x0, i2), unskew << 1);
+		vec y2 = FPAdd<B, F>(FPSub<B, F>(y0, j2), unskew << 1);
+		vec z2 = FPAdd<B, F>(FPSub<B, F>(z0, k2), unskew << 1);
+		vec x3 = FPSub<B, F>(x0, fpc::One >> 1);
+		vec y3 = FPSub<B, F>(y0, fpc::One >> 1);
+		vec z3 = FPSub<B, F>(z0, fpc::One >> 1);
+
+		vec result = FPAdd<B, F>(
+			FPAdd<B, F>(
+				SimplexCorner<B, F>(x0, y0, z0, i, j, k, seed),
+				SimplexCorner<B, F>(x1, y1, z1,
+					FPAdd<B, F>(i, i1), FPAdd<B, F>(j, j1), FPAdd<B, F>(k, k1), seed)
+			),
+			FPAdd<B, F>(
+				SimplexCorner<B, F>(x2, y2, z2,
+					FPAdd<B, F>(i, i2), FPAdd<B, F>(j, j2), FPAdd<B, F>(k, k2), seed),
+				SimplexCorner<B, F>(x3, y3, z3,
+					FPAdd<B, F>(i, 1), FPAdd<B, F>(j, 1), FPAdd<B, F>(k, 1), seed)
+			)
+		);
+
+		// The sum falls in [-1 / 6.728, 1 / 6.728] (found numerically, with the 16x falloff).
+		// Scaling to [-0.5, 0.5], then shifting to [0, 1]. Clamped for rounding.
+		result = FPAdd<B, F>(FPMul<B, F>(result, fp(3.364)), fpc::One >> 1);
+		return FPClamp<B, F>(result, fp(0), fpc::One);
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+
+#endif  // include guard
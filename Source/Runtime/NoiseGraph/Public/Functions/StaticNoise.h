@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_FUNCTIONS_STATICNOISE_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_FUNCTIONS_STATICNOISE_SIMD_H_
+#undef NOISEGRAPH_FUNCTIONS_STATICNOISE_SIMD_H_
+#else
+#define NOISEGRAPH_FUNCTIONS_STATICNOISE_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Numerics/FixedPoint.h"
+#include "Numerics/FixedPointConstants.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "NoiseTypeTraits.h"
+#include "NoiseRange.h"
+
+#include "Functions/Perlin.h"
+#include "Functions/Simplex.h"
+#include "Functions/Cellular.h"
+#include "Functions/Fractal.h"
+#include "Functions/Warp.h"
+
+#include <utility>
+
+// Graphs composed at compile time, for graphs that don't need to change at runtime.
+//
+// Every expression is a small value type that calls the function templates directly, and holds
+// its inputs by value. So the type of a graph is the whole graph, and the compiler can inline it
+// into a single loop without any virtual calls. E.g.:
+//
+//		using Graph = StaticNoise<B, F>;
+//		auto terrain = Graph::Warp(Graph::Fractal(Graph::Perlin(1), 6), Graph::Perlin(2), 1, 4);
+//
+// Expressions satisfy Noise<B, F, 2, Func> and Noise<B, F, 3, Func>, so they can be passed to the
+// function templates as is, along with lambdas. Use StaticNode to sample them with UNoiseGraph.
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Range of an expression's output. Expressions without a GetRange() (e.g. lambdas) have no
+	// known range.
+	template <size_t B, size_t F, typename Func>
+	inline NoiseRange<B, F> GetStaticNoiseRange(const Func& func) {
+		if constexpr (requires { { func.GetRange() } -> std::convertible_to<NoiseRange<B, F>>; }) {
+			return func.GetRange();
+		}
+		else {
+			return NoiseRange<B, F>::Unbounded();
+		}
+	}
+
+	template <size_t B, size_t F>
+	struct StaticPerlin
+	{
+		using vec = V<B, F>;
+
+		HWY_INLINE vec operator()(vec x, vec y) const {
+			return Perlin<B, F>(x, y, Seed);
+		}
+
+		HWY_INLINE vec operator()(vec x, vec y, vec z) const {
+			return Perlin<B, F>(x, y, z, Seed);
+		}
+
+		// Either dimension, so the 3D range, which contains the 2D one.
+		NoiseRange<B, F> GetRange() const {
+			return GetPerlinRange<B, F>(3);
+		}
+
+		FixedPoint<B, F> Seed;
+	};
+
+	template <size_t B, size_t F>
+	struct StaticSimplex
+	{
+		using vec = V<B, F>;
+
+		HWY_INLINE vec operator()(vec x, vec y) const {
+			return Simplex<B, F>(x, y, Seed);
+		}
+
+		HWY_INLINE vec operator()(vec x, vec y, vec z) const {
+			return Simplex<B, F>(x, y, z, Seed);
+		}
+
+		NoiseRange<B, F> GetRange() const {
+			return NoiseRange<B, F>::Unit();
+		}
+
+		FixedPoint<B, F> Seed;
+	};
+
+	template <size_t B, size_t F, size_t Feature>
+	struct StaticCellular
+	{
+		using vec = V<B, F>;
+
+		HWY_INLINE vec operator()(vec x, vec y) const {
+			return Cellular<B, F, Feature>(x, y, Seed, MaxPointsPerGrid);
+		}
+
+		HWY_INLINE vec operator()(vec x, vec y, vec z) const {
+			return Cellular<B, F, Feature>(x, y, z, Seed, MaxPointsPerGrid);
+		}
+
+		// Same as CellularNode::GetRange()
+		NoiseRange<B, F> GetRange() const {
+			if constexpr (Feature == 1) {
+				return NoiseRange<B, F>::Unit();
+			}
+			else if constexpr (Feature == 0) {
+				return NoiseRange<B, F>{ FixedPoint<B, F>(0), FixedPoint<B, F>(2) };
+			}
+			else {
+				return NoiseRange<B, F>{ FixedPoint<B, F>(0), FixedPoint<B, F>(4) };
+			}
+		}
+
+		FixedPoint<B, F> Seed;
+		unsigned int MaxPointsPerGrid;
+	};
+
+	template <size_t B, size_t F, typename Base>
+		requires Noise<B, F, 2, const Base> && Noise<B, F, 3, const Base>
+	struct StaticFractal
+	{
+		using vec = V<B, F>;
+
+		HWY_INLINE vec operator()(vec x, vec y) const {
+			return Fractal<B, F>(x, y, BaseNoise, Octaves, Persistance, Lacunarity);
+		}
+
+		HWY_INLINE vec operator()(vec x, vec y, vec z) const {
+			return Fractal<B, F>(x, y, z, BaseNoise, Octaves, Persistance, Lacunarity);
+		}
+
+		// Same as FractalNode::GetRange(), with the base's range being the same everywhere.
+		NoiseRange<B, F> GetRange() const {
+			const NoiseRange<B, F> sample = GetStaticNoiseRange<B, F>(BaseNoise);
+
+			return GetFractalNoiseRange<B, F>(Octaves, Persistance, Lacunarity,
+				[&](FixedPoint<B, F>) { return sample; });
+		}
+
+		Base BaseNoise;
+		unsigned int Octaves;
+		FixedPoint<B, F> Persistance;
+		FixedPoint<B, F> Lacunarity;
+	};
+
+	template <size_t B, size_t F, typename Base, typename Shift>
+		requires Noise<B, F, 2, const Base> && Noise<B, F, 3, const Base> &&
+			Noise<B, F, 2, const Shift> && Noise<B, F, 3, const Shift>
+	struct StaticWarp
+	{
+		using vec = V<B, F>;
+
+		HWY_INLINE vec operator()(vec x, vec y) const {
+			return Warp<B, F>(x, y, BaseNoise, ShiftNoise, Layers, Strength);
+		}
+
+		HWY_INLINE vec operator()(vec x, vec y, vec z) const {
+			return Warp<B, F>(x, y, z, BaseNoise, ShiftNoise, Layers, Strength);
+		}
+
+		// Warping only moves the coordinates, and the base's range is the same everywhere.
+		NoiseRange<B, F> GetRange() const {
+			return GetStaticNoiseRange<B, F>(BaseNoise);
+		}
+
+		Base BaseNoise;
+		Shift ShiftNoise;
+		unsigned int Layers;
+		FixedPoint<B, F> Strength;
+	};
+
+	// Creates the expressions, with the same defaults as the UNoiseGraph nodes.
+	template <size_t B, size_t F>
+	struct StaticNoise
+	{
+		using fp = FixedPoint<B, F>;
+
+		static constexpr StaticPerlin<B, F> Perlin(fp seed = fp(0)) {
+			return StaticPerlin<B, F>{ seed };
+		}
+
+		static constexpr StaticSimplex<B, F> Simplex(fp seed = fp(0)) {
+			return StaticSimplex<B, F>{ seed };
+		}
+
+		template <size_t Feature = 0>
+		static constexpr StaticCellular<B, F, Feature> Cellular(
+			fp seed = fp(0), unsigned int maxPointsPerGrid = 1
+		) {
+			return StaticCellular<B, F, Feature>{ seed, maxPointsPerGrid };
+		}
+
+		template <typename Base>
+		static constexpr StaticFractal<B, F, Base> Fractal(
+			Base base, unsigned int octaves = 4, fp persistance = fp(0.5), fp lacunarity = fp(2)
+		) {
+			return StaticFractal<B, F, Base>{ std::move(base), octaves, persistance, lacunarity };
+		}
+
+		template <typename Base, typename Shift>
+		static constexpr StaticWarp<B, F, Base, Shift> Warp(
+			Base base, Shift shift, unsigned int layers = 1, fp strength = fp(1)
+		) {
+			return StaticWarp<B, F, Base, Shift>{
+				std::move(base), std::move(shift), layers, strength
+			};
+		}
+	};
+}
+HWY_AFTER_NAMESPACE();
+
+
+#endif  // include guard
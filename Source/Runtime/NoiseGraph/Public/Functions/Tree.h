@@ -15,6 +15,7 @@
 #include "Numerics/FixedPoint.h"
 #include "Numerics/FixedPointConstants.h"
 #include "Numerics/FixedPointSIMD.h"
+#include "Functions/Random.h"
 #include "Numerics/MathVector.h"
 #include "Mathematics/Indexing.h"
 #include "Mathematics/IndexingSIMD.h"
@@ -62,28 +63,32 @@ namespace SIMD::HWY_NAMESPACE
 		const MathVector<int, Dim> Size;
 		const int TotalSize;				// Number of total cells in the depth
 		const int PaddedSize;				// SIMD-adjusted size of the depth tree array
+		const FastDivisor DivisorX;			// Size on x and y, for unravelling cell indices
+		const FastDivisor DivisorY;
 
 		TreeCacheDepthProperties(int depth, MathVector<fp, Dim> start, MathVector<fp, Dim> end) :
 			Interval(fpc::One >> depth),
 			IntervalInverse(fpc::One << depth),
 			Padding((depth == 0) ? 3 : 2),
-			Begin(start.Apply<fp>([&](fp val) -> fp { 
+			Begin(start.template Apply<fp>([&](fp val) -> fp {
 				return Floor(val, depth) - (Interval * Padding); 
 			})),
-			End(start.Apply<fp>([&](fp val) -> fp {
+			End(start.template Apply<fp>([&](fp val) -> fp {
 			return Ceil(val, depth) + (Interval * Padding);
 				})),
 			// ((Ceil(end, depth) - Floor(start, depth)) * IntervalInverse + Padding).ToInt()
 			Size(
 				(
 					(
-						end.Apply<fp>([&](fp val) { return Ceil(val, depth); }) -
-						start.Apply<fp>([&](fp val) { return Floor(val, depth); })
+						end.template Apply<fp>([&](fp val) { return Ceil(val, depth); }) -
+						start.template Apply<fp>([&](fp val) { return Floor(val, depth); })
 					) * IntervalInverse + (Padding * 2)
-				).Apply<int>([](fp val) { return val.ToInt(); })
+				).template Apply<int>([](fp val) { return val.ToInt(); })
 			),
 			TotalSize(Size.Product()),
-			PaddedSize(TotalSize + GetPadding(TotalSize, hn::Lanes(D<B, F>()))) { }
+			PaddedSize(TotalSize + GetPadding(TotalSize, hn::Lanes(D<B, F>()))),
+			DivisorX(Size.Get(0)),
+			DivisorY(Size.Get(1)) { }
 
 	};
 
@@ -128,7 +133,7 @@ namespace SIMD::HWY_NAMESPACE
 
 		// Cell array indices
 		vec arrIdX, arrIdY;
-		VUnravel(i, dp.Size.Get(0), dp.Size.Get(1), arrIdX, arrIdY);
+		VUnravel(i, dp.DivisorX, dp.DivisorY, arrIdX, arrIdY);
 
 		// Cell world coordinates
 		worldX = FPAdd<B, F>(dp.Begin.Get(0), FPMul<B, F>(hn::ShiftLeft<F>(arrIdX), dp.Interval));
@@ -231,6 +236,7 @@ namespace SIMD::HWY_NAMESPACE
 					vec ind = hn::Iota(dc, i);
 					vec branch = ind;
 					vec branchValue = hn::Load(dc, pool.Values.GetPtr() + i);
+					vec indX = Mod(ind, dp.DivisorX);
 
 					// Loops through the 3x3 moore neighbourhood and connects using the func value. 
 					for (int dy = -1; dy <= 1; ++dy) {
@@ -239,7 +245,6 @@ namespace SIMD::HWY_NAMESPACE
 							// Skip out of bounds neighbours (Outside of the values 2d array)
 							mask isInRangeX = hn::Not(hn::MaskFalse(D<B, F>()));
 							mask isInRangeY = isInRangeX;
-							vec indX = Mod(ind, dp.Size.Get(0));
 
 							if (dx < 0) {
 								isInRangeX = hn::Gt(indX, Zero<vec>());
@@ -456,7 +461,7 @@ namespace SIMD::HWY_NAMESPACE
 	// (And implementing the non-cache version is basically just the same code duplicated)
 	template <size_t B, size_t F, typename Func> requires Noise<B, F, 2, Func>
 	inline constexpr V<B, F> Tree(
-		V<B, F> x, V<B, F> y, unsigned int depth, TreeCacheAllocPool<B, F, 2>& pool
+		V<B, F> x, V<B, F> y, unsigned int depth, const TreeCacheAllocPool<B, F, 2>& pool
 	) {
 		using vec = V<B, F>;
 		using mask = M<B, F>;
@@ -477,18 +482,18 @@ namespace SIMD::HWY_NAMESPACE
 					// Get the array indices of the comparison cell. 
 					vec compIndX = GetCellIndex<B, F>(
 						FPAdd<B, F>(x, dx * dninterval),
-						FPBroadcast<B, F>(pool.Trees[dn].Begin[0]), dn);
+						FPBroadcast<B, F>(pool.Trees[dn].Begin.Get(0)), dn);
 					vec compIndY = GetCellIndex<B, F>(
 						FPAdd<B, F>(y, dy * dninterval),
-						FPBroadcast<B, F>(pool.Trees[dn].Begin[1]), dn);
+						FPBroadcast<B, F>(pool.Trees[dn].Begin.Get(1)), dn);
 
-					vec compInd = VFlatten(compIndX, compIndY, pool.Trees[dn].Size[0]);
+					vec compInd = VFlatten(compIndX, compIndY, pool.Trees[dn].Size.Get(0));
 					vec compInd4 = Mul(compInd, 4);
 
 					// Finds the point on the line between the comparison's point and
 					// branch that minimizes distance to the current cell's point. 
 					vec compPointX, compPointY;
-					T<B, F>* ptr = pool.Trees[dn].Tree.GetPtr();
+					const T<B, F>* ptr = pool.Trees[dn].Tree.GetPtr();
 					FPMinimumDistancePoint<B, F>(
 						hn::GatherIndex(dc, ptr + 0, compInd4),
 						hn::GatherIndex(dc, ptr + 1, compInd4),
@@ -18,9 +18,10 @@
 HWY_BEFORE_NAMESPACE();
 namespace SIMD::HWY_NAMESPACE
 {
-	template <size_t B, size_t F, typename Func> requires Noise<B, F, 2, Func>
+	template <size_t B, size_t F, typename Func, typename ShiftFunc = Func>
+		requires Noise<B, F, 2, Func> && Noise<B, F, 2, ShiftFunc>
 	inline constexpr V<B, F> Warp(
-		V<B, F> x, V<B, F> y, Func& base, Func& shift,
+		V<B, F> x, V<B, F> y, Func& base, ShiftFunc& shift,
 		unsigned int layers = 1, FixedPoint<B, F> strength = FixedPoint<B, F>(0.5)
 	) {
 		using vec = V<B, F>;
@@ -47,9 +48,10 @@ namespace SIMD::HWY_NAMESPACE
 		return base(x, y);
 	}
 
-	template <size_t B, size_t F, typename Func> requires Noise<B, F, 3, Func>
+	template <size_t B, size_t F, typename Func, typename ShiftFunc = Func>
+		requires Noise<B, F, 3, Func> && Noise<B, F, 3, ShiftFunc>
 	inline constexpr V<B, F> Warp(
-		V<B, F> x, V<B, F> y, V<B, F> z, Func& base, Func& shift,
+		V<B, F> x, V<B, F> y, V<B, F> z, Func& base, ShiftFunc& shift,
 		unsigned int layers = 1, FixedPoint<B, F> strength = FixedPoint<B, F>(0.5)
 	) {
 		using vec = V<B, F>;
@@ -27,16 +27,81 @@ namespace SIMD::HWY_NAMESPACE
 			unsigned int maxPointsPerGrid = 1
 		) : Seed(seed), MaxPointsPerGrid(maxPointsPerGrid) {}
 
-		vec operator()(vec x, vec y) override {
-			return Cellular<B, F, Feature>(x, y, Seed, MaxPointsPerGrid);
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			State& state = context.GetOrCreateState<State>(this);
+			GetCellularCache<B, F>(
+				bounds, Seed, MaxPointsPerGrid, context.GetSampleCount(), state.Cache
+			);
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			return Cellular<B, F, Feature>(x, y, z, Seed, MaxPointsPerGrid);
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			// Every cell has at least one point, so the closest point is within 2 of the sample,
+			// and the two closest points are within 4 of each other. 
+			if constexpr (Feature == 1) {
+				return NoiseRange<B, F>::Unit();
+			}
+			else if constexpr (Feature == 0) {
+				return NoiseRange<B, F>{ FixedPoint<B, F>(0), FixedPoint<B, F>(2) };
+			}
+			else {
+				return NoiseRange<B, F>{ FixedPoint<B, F>(0), FixedPoint<B, F>(4) };
+			}
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			const CellularCache<B, F>* cache = FindCache(block.Context);
+
+			if (cache) {
+				this->EvaluateVectors(block, out,
+					[&](vec x, vec y) {
+						return Cellular<B, F, Feature>(x, y, Seed, MaxPointsPerGrid, *cache);
+					},
+					[&](vec x, vec y, vec z) {
+						return Cellular<B, F, Feature>(x, y, z, Seed, MaxPointsPerGrid, *cache);
+					}
+				);
+				return;
+			}
+
+			this->EvaluateVectors(block, out,
+				[&](vec x, vec y) {
+					return Cellular<B, F, Feature>(x, y, Seed, MaxPointsPerGrid);
+				},
+				[&](vec x, vec y, vec z) {
+					return Cellular<B, F, Feature>(x, y, z, Seed, MaxPointsPerGrid);
+				}
+			);
+		}
+
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			const NoiseOp op = static_cast<NoiseOp>(int(NoiseOp::Cellular0) + int(Feature));
+			return builder.EmitSample(op, coords, Seed, MaxPointsPerGrid, this);
+		}
+
+		// Feature points cached by PreProcess(), or nullptr if they weren't cached for the
+		// sampled bounds.
+		const CellularCache<B, F>* FindCache(const NoiseExecutionContext& context) const {
+			const State* state = context.FindState<State>(this);
+			return (state && state->Cache.IsValid) ? &state->Cache : nullptr;
 		}
 
 		FixedPoint<B, F> Seed;
 		unsigned int MaxPointsPerGrid;
+
+	protected:
+		// Cache built by every PreProcess(), for the bounds being sampled. Kept in the context so
+		// that its allocation is reused by the context's next call.
+		struct State : NoiseNodeState
+		{
+			CellularCache<B, F> Cache;
+		};
 	};
 }
 HWY_AFTER_NAMESPACE();
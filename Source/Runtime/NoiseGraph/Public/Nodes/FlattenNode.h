@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NODEGRAPH_NODES_FLATTEN_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NODEGRAPH_NODES_FLATTEN_SIMD_H_
+#undef NODEGRAPH_NODES_FLATTEN_SIMD_H_
+#else
+#define NODEGRAPH_NODES_FLATTEN_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Nodes/NodeBaseSIMD.h"
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Samples the base in 2D, ignoring z. E.g. the 2D terrain height under a 3D heightmap.
+	// Flattened subgraphs don't depend on z, so they are only evaluated once per column of a 3D 
+	// grid. 
+	template <size_t B, size_t F>
+	class FlattenNode : public NodeBaseSIMD<B, F>
+	{
+	public:
+		FlattenNode(std::shared_ptr<NodeBaseSIMD<B, F>> base) :Base(base) {}
+		virtual ~FlattenNode() = default;
+
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			Base->PreProcess(GetBounds2D(bounds), context);
+		}
+
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			return Base->GetRange(GetBounds2D(bounds));
+		}
+
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			return Base->GetAxes(2) & NoiseAxes::XY;
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			Base->Evaluate(block.WithCoordinates(block.X, block.Y, nullptr), out);
+		}
+
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			return Base->Compile(
+				builder, typename NoiseProgramBuilder<B, F>::Coordinates{ coords.X, coords.Y, -1 });
+		}
+
+		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
+
+	protected:
+		static std::vector<NoiseSamplingBound<B, F>> GetBounds2D(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) {
+			return std::vector<NoiseSamplingBound<B, F>>(
+				bounds.begin(), bounds.begin() + std::min(bounds.size(), size_t(2)));
+		}
+	};
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
@@ -30,10 +30,13 @@ namespace SIMD::HWY_NAMESPACE
 
 		virtual ~FractalNode() = default;
 
-		virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) override {
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
 			std::vector<NoiseSamplingBound<B, F>> newBounds = bounds;
 
-			// The higher the frequency, the smaller and closer the highest octave samples go to 0
+			// Octaves sample the bounds scaled by 1 up to the highest octave's frequency, so the base
+			// is sampled within the union of the lowest and highest octave bounds.
 			FixedPoint<B, F> frequencyScale = 1;
 
 			for (size_t i = 1; i < Octaves; ++i) {
@@ -41,30 +44,128 @@ namespace SIMD::HWY_NAMESPACE
 			}
 
 			for (size_t i = 0; i < newBounds.size(); ++i) {
-				newBounds[i].Start = 
-					(newBounds[i].Start < 0) ? 
-					newBounds[i].Start :
-					(newBounds[i].Start * frequencyScale);
-
-				newBounds[i].End =
-					(newBounds[i].End < 0) ?
-					(newBounds[i].End * frequencyScale) :
-					newBounds[i].End;
+				const FixedPoint<B, F> start = newBounds[i].Start * frequencyScale;
+				const FixedPoint<B, F> end = newBounds[i].End * frequencyScale;
+
+				newBounds[i].Start = (start < newBounds[i].Start) ? start : newBounds[i].Start;
+				newBounds[i].End = (end > newBounds[i].End) ? end : newBounds[i].End;
 			}
 
-			Base->PreProcess(newBounds);
+			Base->PreProcess(newBounds, context);
 		}
 
-		vec operator()(vec x, vec y) override {
-			return Fractal<B, F, NodeBaseSIMD<B, F>>(
-				x, y, *Base, Octaves, Persistance, Lacunarity
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			return GetFractalNoiseRange<B, F>(Octaves, Persistance, Lacunarity,
+				[&](FixedPoint<B, F> frequency) {
+					std::vector<NoiseSamplingBound<B, F>> octaveBounds = bounds;
+
+					for (NoiseSamplingBound<B, F>& bound : octaveBounds) {
+						NoiseRange<B, F> scaled = NoiseRange<B, F>::Of(
+							bound.Start * frequency, bound.End * frequency);
+						bound.Start = scaled.Min;
+						bound.End = scaled.Max;
+					}
+
+					return Base->GetRange(octaveBounds);
+				}
 			);
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			return Fractal<B, F, NodeBaseSIMD<B, F>>(
-				x, y, z, *Base, Octaves, Persistance, Lacunarity
-			);
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			return Base->GetAxes(dimensions);
+		}
+
+		// Same as Fractal(), but every octave samples the base over the whole block at once. 
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			using fp = FixedPoint<B, F>;
+			using fpc = FixedPointConstant<B, F>;
+			const D<B, F> d;
+			const bool is3D = block.Is3D();
+
+			ScratchBuffer<B, F> x, y, z, sample;
+			const NoiseBlock<B, F> octaveBlock = block.WithCoordinates(x, y, is3D ? z.Get() : nullptr);
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				hn::Store(Zero<vec>(), d, out + i);
+			});
+
+			fp maxValue = 0;
+			fp amplitude = fpc::One;
+			fp frequency = fpc::One;
+
+			for (unsigned int o = 0; o < Octaves; ++o) {
+				vec vfreq = FPBroadcast<B, F>(frequency);
+
+				ForEachVector<B, F>(block.Count, [&](int i) {
+					hn::Store(FPMul<B, F>(hn::Load(d, block.X + i), vfreq), d, x + i);
+					hn::Store(FPMul<B, F>(hn::Load(d, block.Y + i), vfreq), d, y + i);
+
+					if (is3D) {
+						hn::Store(FPMul<B, F>(hn::Load(d, block.Z + i), vfreq), d, z + i);
+					}
+				});
+
+				Base->Evaluate(octaveBlock, sample);
+
+				ForEachVector<B, F>(block.Count, [&](int i) {
+					vec value = FPAdd<B, F>(
+						hn::Load(d, out + i),
+						FPMul<B, F>(
+							FPSub<B, F>(hn::ShiftLeft<1>(hn::Load(d, sample + i)), 1),
+							amplitude
+						)
+					);
+					hn::Store(value, d, out + i);
+				});
+
+				maxValue += amplitude;
+
+				amplitude *= Persistance;
+				frequency *= Lacunarity;
+			}
+
+			if (maxValue == 0) return;
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				// Scale from [-mv, mv] to [-0.5, 0.5], then shift to [0, 1]
+				vec value = FPDiv<B, F>(hn::Load(d, out + i), maxValue << 1);
+				value = FPAdd<B, F>(value, fp(1) >> 1);
+				hn::Store(value, d, out + i);
+			});
+		}
+
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			using fp = FixedPoint<B, F>;
+			using fpc = FixedPointConstant<B, F>;
+
+			int value = builder.Emit(NoiseOp::Zero, {});
+			fp maxValue = 0;
+			fp amplitude = fpc::One;
+			fp frequency = fpc::One;
+
+			for (unsigned int o = 0; o < Octaves; ++o) {
+				typename NoiseProgramBuilder<B, F>::Coordinates octaveCoords{
+					builder.Emit(NoiseOp::Scale, { coords.X }, frequency),
+					builder.Emit(NoiseOp::Scale, { coords.Y }, frequency),
+					coords.Is3D() ? builder.Emit(NoiseOp::Scale, { coords.Z }, frequency) : -1
+				};
+
+				int sample = Base->Compile(builder, octaveCoords);
+				value = builder.Emit(NoiseOp::FractalAccumulate, { value, sample }, amplitude);
+
+				maxValue += amplitude;
+
+				amplitude *= Persistance;
+				frequency *= Lacunarity;
+			}
+
+			if (maxValue == 0) return value;
+			return builder.Emit(NoiseOp::FractalNormalize, { value }, maxValue);
 		}
 
 		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
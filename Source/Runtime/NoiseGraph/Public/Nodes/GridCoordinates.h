@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_NODES_GRIDCOORDINATES_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_NODES_GRIDCOORDINATES_SIMD_H_
+#undef NOISEGRAPH_NODES_GRIDCOORDINATES_SIMD_H_
+#else
+#define NOISEGRAPH_NODES_GRIDCOORDINATES_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Mathematics/IndexingSIMD.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "NoiseSamplingParameters.h"
+#include <cstdint>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Writes the coordinates of the grid samples with flattened indices [begin, begin + count) 
+	// to x, y (and z in 3D). Every vector that overlaps the range is written.
+	//
+	// Unravelling the index of every vector takes integer divisions, which most targets emulate
+	// lane by lane. Instead, only the first vector is unravelled, and the index and coordinate
+	// of every lane are then advanced by a vector of samples at a time. A vector always spans
+	// the same number of rows and columns, so every axis needs at most one carry into the next.
+	//
+	// Same as VUnravel(), indices past the end of the grid wrap around to its start, so that
+	// every lane stays within the bounds.
+	template <size_t B, size_t F, size_t Dimensions>
+	HWY_INLINE void GenerateGridCoordinates(
+		const NoiseSamplingParameters<B, F>& params, int begin, int count,
+		T<B, F>* HWY_RESTRICT x, T<B, F>* HWY_RESTRICT y, T<B, F>* HWY_RESTRICT z
+	) {
+		static_assert(Dimensions == 2 || Dimensions == 3);
+
+		using vec = V<B, F>;
+		using base_type = typename FixedPoint<B, F>::base_type;
+
+		const D<B, F> d;
+		const int laneCount = hn::Lanes(d);
+		const base_type spacing = params.Spacing.ToRaw();
+
+		vec idX, idY, idZ;
+
+		if constexpr (Dimensions == 2) {
+			VUnravel(begin, params.Size(0), params.Size(1), idX, idY);
+		}
+		else {
+			VUnravel(begin, params.Size(0), params.Size(1), params.Size(2), idX, idY, idZ);
+		}
+
+		// Splits a vector of samples into steps along each axis, before carrying. 
+		int sizes[3] = { params.Size(0), params.Size(1), Dimensions == 3 ? params.Size(2) : 1 };
+		int steps[3];
+		base_type stepOffsets[3];	// steps * spacing
+		base_type spans[3];			// sizes * spacing
+
+		for (int a = 0, remaining = laneCount; a < 3; ++a) {
+			steps[a] = remaining % sizes[a];
+			stepOffsets[a] = static_cast<base_type>(int64_t(steps[a]) * spacing);
+			spans[a] = static_cast<base_type>(int64_t(sizes[a]) * spacing);
+			remaining /= sizes[a];
+		}
+
+		auto CoordinateLambda = [&](vec indices, size_t axis) {
+			return sn::Add(sn::Mul(indices, spacing), params.Start(axis).ToRaw());
+		};
+
+		vec cX = CoordinateLambda(idX, 0);
+		vec cY = CoordinateLambda(idY, 1);
+		vec cZ = (Dimensions == 3) ? CoordinateLambda(idZ, 2) : cY;
+
+		// Wraps the lanes that went past the end of axis a. Returns the carry into the next axis.
+		auto WrapLambda = [&](vec& indices, vec& coordinates, int a) {
+			auto carry = hn::Ge(indices, hn::Set(d, sizes[a]));
+			indices = hn::IfThenElse(carry, sn::Sub(indices, sizes[a]), indices);
+			coordinates = hn::IfThenElse(carry, sn::Sub(coordinates, spans[a]), coordinates);
+			return carry;
+		};
+
+		// Advances axis a by its steps, plus one in the lanes the previous axis carried from.
+		auto AdvanceLambda = [&](vec& indices, vec& coordinates, int a, auto carry) {
+			indices = sn::Add(indices, 
+				hn::IfThenElse(carry, hn::Set(d, steps[a] + 1), hn::Set(d, steps[a])));
+			const base_type carryOffset = base_type(int64_t(stepOffsets[a]) + spacing);
+			coordinates = sn::Add(coordinates, 
+				hn::IfThenElse(carry, hn::Set(d, carryOffset), hn::Set(d, stepOffsets[a])));
+			return WrapLambda(indices, coordinates, a);
+		};
+
+		for (int i = 0; i < count; i += laneCount) {
+			hn::Store(cX, d, x + i);
+			hn::Store(cY, d, y + i);
+			if constexpr (Dimensions == 3) hn::Store(cZ, d, z + i);
+
+			idX = sn::Add(idX, steps[0]);
+			cX = sn::Add(cX, stepOffsets[0]);
+
+			auto carry = WrapLambda(idX, cX, 0);
+			carry = AdvanceLambda(idY, cY, 1, carry);
+			if constexpr (Dimensions == 3) AdvanceLambda(idZ, cZ, 2, carry);
+		}
+	}
+
+	// Calls rowFunc(i, ix, iy, iz) for the vectors of the grid samples [begin, begin + count)
+	// that lie within a single row of the grid, with the indices of their first sample, and
+	// func(i) for the others (vectors that wrap into the next row, or past the end of the grid).
+	// iz is always 0 in 2D. Same as ForEachVector(), i is the offset of the vector in the range.
+	template <size_t B, size_t F, typename RowFunc, typename Func>
+	HWY_INLINE void ForEachGridVector(
+		const NoiseSamplingParameters<B, F>& params, int begin, int count,
+		RowFunc&& rowFunc, Func&& func
+	) {
+		const int laneCount = hn::Lanes(D<B, F>());
+		const int sizeX = params.Size(0);
+		const int sizeY = params.Size(1);
+		const int end = params.TotalSize();
+
+		int ix = begin % sizeX;
+		int iy = (begin / sizeX) % sizeY;
+		int iz = (begin / sizeX) / sizeY;
+
+		for (int i = 0; i < count; i += laneCount) {
+			if (ix + laneCount <= sizeX && begin + i + laneCount <= end) {
+				rowFunc(i, ix, iy, iz);
+			}
+			else {
+				func(i);
+			}
+
+			for (ix += laneCount; ix >= sizeX; ix -= sizeX) {
+				if (++iy == sizeY) {
+					iy = 0;
+					++iz;
+				}
+			}
+		}
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
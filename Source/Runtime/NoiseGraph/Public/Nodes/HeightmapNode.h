@@ -30,20 +30,75 @@ namespace SIMD::HWY_NAMESPACE
 
 		virtual ~HeightmapNode() = default;
 
-		virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) override {
-			Base->PreProcess(bounds);
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			Base->PreProcess(bounds, context);
 		}
 
-		vec operator()(vec x, vec y) override {
-			return (*Base)(x, y);
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			NoiseRange<B, F> range = Base->GetRange(bounds);
+
+			if (bounds.size() < 3) {
+				return range;
+			}
+
+			// The bias is monotonic in z, so its range is at the ends of the z bounds. 
+			auto BiasLambda = [&](fp z) {
+				fp bias = (z - LowerBound) / (UpperBound - LowerBound);
+				return std::clamp(bias, fp(0), fpc::One);
+			};
+
+			NoiseRange<B, F> bias = NoiseRange<B, F>::Of(
+				BiasLambda(bounds[2].Start), BiasLambda(bounds[2].End));
+
+			// Widened by a few units, since the sampled bias is rounded differently.
+			bias = bias.Widen(fp::FromBase(4));
+
+			return NoiseRange<B, F>{
+				std::max(range.Min - bias.Max, fp(0)),
+				std::max(range.Max - bias.Min, fp(0))
+			};
+		}
+
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			// The bias only depends on z.
+			const NoiseAxes axes = Base->GetAxes(dimensions);
+			return (dimensions >= 3) ? (axes | NoiseAxes::Z) : axes;
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			// We want the sampler bias to be 0 at upper bound, and 1 at lower bound. 
-			vec zBias = FPSub<B, F>(z, LowerBound); // Shift z so that lower bound is 0.
-			vec bias = FPDiv<B, F>(zBias, UpperBound - LowerBound); // bias of z in bounds
-			bias = FPClamp<B, F>(bias, 0, fpc::One);	// In case z is outside of bounds
-			return sn::Max(sn::Sub((*Base)(x, y, z), bias), Zero<vec>());
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			const D<B, F> d;
+			Base->Evaluate(block, out);
+
+			if (!block.Is3D()) {
+				return;
+			}
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				// We want the sampler bias to be 0 at upper bound, and 1 at lower bound. 
+				vec z = hn::Load(d, block.Z + i);
+				vec zBias = FPSub<B, F>(z, LowerBound); // Shift z so that lower bound is 0.
+				vec bias = FPDiv<B, F>(zBias, UpperBound - LowerBound); // bias of z in bounds
+				bias = FPClamp<B, F>(bias, 0, fpc::One);	// In case z is outside of bounds
+				vec value = sn::Max(sn::Sub(hn::Load(d, out + i), bias), Zero<vec>());
+				hn::Store(value, d, out + i);
+			});
+		}
+
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			int value = Base->Compile(builder, coords);
+
+			if (!coords.Is3D()) {
+				return value;
+			}
+
+			return builder.Emit(NoiseOp::HeightBias, { value, coords.Z }, UpperBound, LowerBound);
 		}
 
 		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
@@ -24,16 +24,39 @@ namespace SIMD::HWY_NAMESPACE
 		InvertNode(std::shared_ptr<NodeBaseSIMD<B, F>> base) :Base(base) {}
 		virtual ~InvertNode() = default;
 
-		virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) override {
-			Base->PreProcess(bounds);
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			Base->PreProcess(bounds, context);
 		}
 
-		vec operator()(vec x, vec y) override {
-			return FPSub<B, F>(fpc::One, (*Base)(x, y));
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			NoiseRange<B, F> range = Base->GetRange(bounds);
+			if (range.IsUnbounded()) return range;
+
+			return NoiseRange<B, F>{ fpc::One - range.Max, fpc::One - range.Min };
+		}
+
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			return Base->GetAxes(dimensions);
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			const D<B, F> d;
+			Base->Evaluate(block, out);
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				hn::Store(FPSub<B, F>(fpc::One, hn::Load(d, out + i)), d, out + i);
+			});
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			return FPSub<B, F>(fpc::One, (*Base)(x, y, z));
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			return builder.Emit(NoiseOp::OneMinus, { Base->Compile(builder, coords) });
 		}
 
 		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
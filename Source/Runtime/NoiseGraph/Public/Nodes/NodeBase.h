@@ -3,48 +3,273 @@
 #pragma once
 
 #include "NoiseSamplingParameters.h"
+#include "NoiseOutputView.h"
+#include "NoiseSampleStats.h"
+#include "NoiseExecutionContext.h"
+#include "NoiseRange.h"
+#include "NoiseAxes.h"
 #include "AlignedArray.h"
+#include "hwy/base.h"
+#include <algorithm>
 #include <variant>
 #include <TypeTraits/VariantTypeTraits.h>
 
+#include "Async/ParallelFor.h"
+
 
 template <size_t B, size_t F>
 class NodeBase
 {
 public:
-	using VarPtr = std::variant<uint8_t*, uint16_t*, uint32_t*, uint64_t*>;
+	using VarPtr = std::variant<
+		uint8_t*, uint16_t*, uint32_t*, uint64_t*,
+		int8_t*, int16_t*, int32_t*, int64_t*,
+		hwy::float16_t*, float*
+	>;
+	using VarView = std::variant<
+		NoiseOutputView<uint8_t>, NoiseOutputView<uint16_t>, 
+		NoiseOutputView<uint32_t>, NoiseOutputView<uint64_t>,
+		NoiseOutputView<int8_t>, NoiseOutputView<int16_t>, 
+		NoiseOutputView<int32_t>, NoiseOutputView<int64_t>,
+		NoiseOutputView<hwy::float16_t>, NoiseOutputView<float>
+	>;
+	using base_type = typename FixedPoint<B, F>::base_type;
+
+	// Number of samples a worker writes at a time in ProcessParallel(). 
+	// Small enough that a tile's output stays in L1/L2, and a multiple of every SIMD lane count so
+	// that tiles start on vector boundaries (which keeps the output identical to Process()). 
+	static constexpr int TileSize = 4096;
+
+	// Outputs larger than this (in bytes, about the size of a last-level cache) are written with
+	// non-temporal stores, so that they don't evict the nodes' caches. 
+	static constexpr size_t StreamingStoreSize = size_t(32) << 20;
 
 	NodeBase() = default;
 	virtual ~NodeBase() = default;
 
+	// Nodes are immutable once built. Anything created per sample call must be stored in the 
+	// context, so that the same node can be sampled by several threads at once. 
+
 	// To be implemented by nodes.
 	// Note - Bounds is used instead of the sampling parameters because the spacing / count of 
 	// samples cannot be assumed. Some noise like warp will mess with spacing. So caching should
 	// take that into account. 
-	virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) {
+	virtual void PreProcess(
+		const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context) const {
+
+	}
+
+	// Called by the sampler instead of PreProcess() when the samples are on the regular grid of 
+	// params, for nodes that precompute values over the grid itself rather than its bounds. 
+	// Process() must then be called with the same params. 
+	virtual void PreProcessGrid(
+		const NoiseSamplingParameters<B, F>& params, NoiseExecutionContext& context) const {
+		context.SetSampleCount(params.TotalSize());
+		PreProcess(params.GetBounds(), context);
+	}
 
+	// To be implemented by nodes. Returns the axes the node's output depends on, when sampled with
+	// the given number of dimensions. Values that don't depend on z are evaluated once per XY 
+	// column of a 3D grid. Nodes that don't implement it depend on every axis. 
+	virtual NoiseAxes GetAxes(size_t dimensions) const {
+		return NoiseAxesOf(dimensions);
+	}
+
+	// To be implemented by nodes. Returns a conservative range of the values the node outputs 
+	// within the bounds, without sampling. Used to skip regions that are entirely on one side of
+	// an isosurface. Nodes that don't implement it have no known range. 
+	virtual NoiseRange<B, F> GetRange(const std::vector<NoiseSamplingBound<B, F>>& bounds) const {
+		return NoiseRange<B, F>::Unbounded();
 	}
 
 	// to be implemented by nodes. Cleanup for anything created in PreProcess()
-	virtual void PostProcess() {
+	virtual void PostProcess(NoiseExecutionContext& context) const {
 
 	}
 
 	// Non-simd accessible version of Process. 
+	// If stats isn't nullptr, the statistics of the samples are added to it as they are written.
 	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
 	void Process(
-		NoiseSamplingParameters<B, F> params, 
-		AlignedArray<T>& array) {
+		const NoiseSamplingParameters<B, F>& params, 
+		AlignedArray<T>& array,
+		const NoiseExecutionContext& context,
+		NoiseSampleStats<B, F>* stats = nullptr) const {
 
 		// Ensure the output aligned array is large enough to 
 		assert(params.TotalSize() <= array.GetSize());
-		ProcessSIMD(params, array.GetPtr());
+		ProcessSIMD(params, array.GetPtr(), 0, params.TotalSize(), context, stats);
+	}
+
+	// Same as Process(), but splits the sampled region into tiles of TileSize samples and 
+	// processes the tiles on the worker threads. Every sample only depends on its own coordinate 
+	// (and on what was built in PreProcess()), so the output is bit-identical to Process(). 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessParallel(
+		const NoiseSamplingParameters<B, F>& params,
+		AlignedArray<T>& array,
+		const NoiseExecutionContext& context,
+		NoiseSampleStats<B, F>* stats = nullptr) const {
+
+		assert(params.TotalSize() <= array.GetSize());
+		const int count = params.TotalSize();
+		const int tileCount = (count + TileSize - 1) / TileSize;
+		VarPtr outArray = array.GetPtr();
+
+		// Every tile has its own stats, merged once done. 
+		std::vector<NoiseSampleStats<B, F>> tileStats;
+		if (stats) tileStats.resize(tileCount, NoiseSampleStats<B, F>(stats->Threshold));
+
+		ParallelFor(tileCount, [&](int32 tile) {
+			const int begin = tile * TileSize;
+			ProcessSIMD(
+				params, outArray, begin, std::min(begin + TileSize, count), context,
+				stats ? &tileStats[tile] : nullptr
+			);
+		});
+
+		for (const NoiseSampleStats<B, F>& tile : tileStats) {
+			stats->Merge(tile);
+		}
+	}
+
+	// Same as Process(), but only writes the samples with flattened indices [begin, end). Used to
+	// run the tiles of a sample call separately (e.g. SampleAsync()). begin must be a multiple of 
+	// TileSize, so that the output is identical to Process(). 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessRange(
+		const NoiseSamplingParameters<B, F>& params,
+		AlignedArray<T>& array, int begin, int end,
+		const NoiseExecutionContext& context,
+		NoiseSampleStats<B, F>* stats = nullptr) const {
+
+		assert(0 <= begin && begin <= end && end <= params.TotalSize());
+		assert(params.TotalSize() <= array.GetSize());
+		ProcessSIMD(params, array.GetPtr(), begin, end, context, stats);
+	}
+
+	// Same as Process(), but writes through a view of caller-owned memory rather than into a 
+	// dense array. The view must cover every sample of params. 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessView(
+		const NoiseSamplingParameters<B, F>& params,
+		const NoiseOutputView<T>& view,
+		const NoiseExecutionContext& context) const {
+
+		ProcessViewSIMD(params, view, 0, params.TotalSize(), context);
+	}
+
+	// Same as ProcessParallel(), but writes through a view. Every sample has its own elements in
+	// the view, so tiles never write to the same memory. 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessViewParallel(
+		const NoiseSamplingParameters<B, F>& params,
+		const NoiseOutputView<T>& view,
+		const NoiseExecutionContext& context) const {
+
+		const int count = params.TotalSize();
+		const int tileCount = (count + TileSize - 1) / TileSize;
+		const VarView outView = view;
+
+		ParallelFor(tileCount, [&](int32 tile) {
+			const int begin = tile * TileSize;
+			ProcessViewSIMD(params, outView, begin, std::min(begin + TileSize, count), context);
+		});
+	}
+
+	// Same as Process(), but samples several regions into their own arrays in a single pass. 
+	// PreProcess() must have been called with bounds that contain every region (see 
+	// GetNoiseBoundsUnion()). All regions must have the same number of dimensions. 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessBatch(
+		const std::vector<NoiseSamplingParameters<B, F>>& regions,
+		std::vector<AlignedArray<T>>& arrays,
+		const NoiseExecutionContext& context) const {
+
+		assert(regions.size() == arrays.size());
+		std::vector<VarPtr> outArrays;
+		outArrays.reserve(arrays.size());
+
+		for (size_t i = 0; i < regions.size(); ++i) {
+			assert(regions[i].TotalSize() <= arrays[i].GetSize());
+			outArrays.push_back(arrays[i].GetPtr());
+		}
+
+		ProcessBatchSIMD(regions.data(), outArrays.data(), int(regions.size()), context);
+	}
+
+	// Number of values the node outputs per sample. Nodes with several outputs (e.g. a compiled 
+	// program with an output per named graph output) are sampled with ProcessOutputs(). 
+	virtual int GetOutputCount() const {
+		return 1;
+	}
+
+	// Same as Process(), but writes output j of the node to arrays[j]. Every output is computed 
+	// in the same pass over the samples. 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessOutputs(
+		const NoiseSamplingParameters<B, F>& params,
+		std::vector<AlignedArray<T>>& arrays,
+		const NoiseExecutionContext& context) const {
+
+		assert(int(arrays.size()) == GetOutputCount());
+		std::vector<VarPtr> outArrays;
+		outArrays.reserve(arrays.size());
+
+		for (AlignedArray<T>& array : arrays) {
+			assert(params.TotalSize() <= array.GetSize());
+			outArrays.push_back(array.GetPtr());
+		}
+
+		ProcessOutputsSIMD(
+			params, outArrays.data(), int(outArrays.size()), 0, params.TotalSize(), context);
+	}
+
+	// Same as Process(), but samples at count arbitrary points instead of a grid. Value i of the
+	// array is the value at (x[i], y[i], z[i]). z is nullptr for 2D points. 
+	// The points must be within the bounds given to PreProcess(). 
+	template <typename T> requires exists_in_variant_v<T, VarPtr, true>
+	void ProcessPoints(
+		const base_type* x, const base_type* y, const base_type* z, int count,
+		AlignedArray<T>& array,
+		const NoiseExecutionContext& context) const {
+
+		assert(count <= array.GetSize());
+		ProcessPointsSIMD(x, y, z, count, array.GetPtr(), context);
 	}
 
 protected:
 	// Implemented in NodeBaseSIMD.
+	// Writes the values at count points to the output array.
+	virtual void ProcessPointsSIMD(
+		const base_type* x, const base_type* y, const base_type* z, int count, VarPtr outArray,
+		const NoiseExecutionContext& context) const { }
+
+	// Implemented in NodeBaseSIMD.
+	// Writes the samples of count regions to their output arrays. 
+	virtual void ProcessBatchSIMD(
+		const NoiseSamplingParameters<B, F>* regions, const VarPtr* outArrays, int count,
+		const NoiseExecutionContext& context) const { }
+
+	// Implemented in NodeBaseSIMD.
+	// Writes the samples with flattened indices [begin, end) of the sampled region to the view.
+	virtual void ProcessViewSIMD(
+		const NoiseSamplingParameters<B, F>& params, const VarView& outView, int begin, int end,
+		const NoiseExecutionContext& context) const { }
+
+	// Implemented in NodeBaseSIMD.
+	// Writes the samples with flattened indices [begin, end) of each output to its array. 
+	virtual void ProcessOutputsSIMD(
+		const NoiseSamplingParameters<B, F>& params, const VarPtr* outArrays, int outputCount,
+		int begin, int end, const NoiseExecutionContext& context) const { }
+
+	// Implemented in NodeBaseSIMD.
+	// Writes the samples with flattened indices [begin, end) of the sampled region, and adds 
+	// their statistics to stats if it isn't nullptr. 
 	// This function does NOT check for bounds, nor control lifetime of the output array!!
-	virtual void ProcessSIMD(NoiseSamplingParameters<B, F> params, VarPtr outArray) { }
+	virtual void ProcessSIMD(
+		const NoiseSamplingParameters<B, F>& params, VarPtr outArray, int begin, int end,
+		const NoiseExecutionContext& context, NoiseSampleStats<B, F>* stats) const { }
 
 };
 
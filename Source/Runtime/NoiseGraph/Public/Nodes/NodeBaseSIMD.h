@@ -9,11 +9,21 @@
 #endif
 
 #include "hwy/highway.h"
+#include "hwy/cache_control.h"
 #include "Mathematics/IndexingSIMD.h"
 #include "Numerics/FixedPointSIMD.h"
 #include "NoiseSamplingParameters.h"
 #include "NodeBase.h"
+#include "Nodes/NoiseBlock.h"
+#include "Nodes/GridCoordinates.h"
+#include "Cryptography/HashSIMD.h"
+#include "NoiseSampleStats.h"
+#include "Program/NoiseProgram.h"
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
 #include <variant>
+#include <vector>
 
 HWY_BEFORE_NAMESPACE();
 namespace SIMD::HWY_NAMESPACE
@@ -23,108 +33,640 @@ namespace SIMD::HWY_NAMESPACE
 	{
 		using vec = V<B, F>;
 		using typename NodeBase<B, F>::VarPtr;
+		using typename NodeBase<B, F>::VarView;
 
 	public:
 		NodeBaseSIMD() = default;
 		virtual ~NodeBaseSIMD() = default;
 
-		virtual vec operator()(vec x, vec y) {
-			return Zero<vec>();
+		// To be implemented by nodes. Writes the value of every sample in the block to out. 
+		// Evaluation is done a block at a time so that there is one virtual call per node per 
+		// block (rather than per vector), and the loops within a node can be fully inlined.
+		virtual void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const {
+			const D<B, F> d;
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				hn::Store(Zero<vec>(), d, out + i);
+			});
 		}
 
-		virtual vec operator()(vec x, vec y, vec z) {
-			return Zero<vec>();
+		// To be implemented by nodes with several outputs. Writes output j of every sample in the
+		// block to outputs[j]. Nodes with a single output write their value to outputs[0]. 
+		virtual void EvaluateOutputs(
+			const NoiseBlock<B, F>& block, T<B, F>* const* outputs
+		) const {
+			Evaluate(block, outputs[0]);
+		}
+
+		// To be implemented by nodes that can be lowered into a NoiseProgram. Emits the node's 
+		// instructions for sampling at coords, and returns the register holding its value. 
+		// Nodes that don't implement it are called as is by the program. 
+		virtual int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const {
+			return builder.EmitCall(*this, coords);
+		}
+
+		// Single vector versions of Evaluate(). Only for convenience (e.g. building caches), since
+		// a single vector is a very small block. 
+		vec operator()(vec x, vec y, const NoiseExecutionContext& context) const {
+			const D<B, F> d;
+			HWY_ALIGN T<B, F> bx[hn::MaxLanes(d)];
+			HWY_ALIGN T<B, F> by[hn::MaxLanes(d)];
+			HWY_ALIGN T<B, F> out[hn::MaxLanes(d)];
+			hn::Store(x, d, bx);
+			hn::Store(y, d, by);
+			Evaluate(NoiseBlock<B, F>{ bx, by, nullptr, int(hn::Lanes(d)), context }, out);
+			return hn::Load(d, out);
+		}
+
+		vec operator()(vec x, vec y, vec z, const NoiseExecutionContext& context) const {
+			const D<B, F> d;
+			HWY_ALIGN T<B, F> bx[hn::MaxLanes(d)];
+			HWY_ALIGN T<B, F> by[hn::MaxLanes(d)];
+			HWY_ALIGN T<B, F> bz[hn::MaxLanes(d)];
+			HWY_ALIGN T<B, F> out[hn::MaxLanes(d)];
+			hn::Store(x, d, bx);
+			hn::Store(y, d, by);
+			hn::Store(z, d, bz);
+			Evaluate(NoiseBlock<B, F>{ bx, by, bz, int(hn::Lanes(d)), context }, out);
+			return hn::Load(d, out);
 		}
 
 	protected:
 		// Virtual variant to concrete T version of the Process function
-		virtual void ProcessSIMD(NoiseSamplingParameters<B, F> params, VarPtr outptr) final {
+		virtual void ProcessSIMD(
+			const NoiseSamplingParameters<B, F>& params, VarPtr outptr, int begin, int end,
+			const NoiseExecutionContext& context, NoiseSampleStats<B, F>* stats
+		) const final {
+			std::visit([&](auto&& ptr) {
+				ProcessSIMDImpl(params, ptr, begin, end, context, stats);
+				}, outptr);
+		}
+
+		virtual void ProcessPointsSIMD(
+			const T<B, F>* px, const T<B, F>* py, const T<B, F>* pz, int count, VarPtr outptr,
+			const NoiseExecutionContext& context
+		) const final {
 			std::visit([&](auto&& ptr) {
-				ProcessSIMDImpl(params, ptr);
+				ProcessPointsSIMDImpl(px, py, pz, count, ptr, context);
 				}, outptr);
 		}
 
+		virtual void ProcessBatchSIMD(
+			const NoiseSamplingParameters<B, F>* regions, const VarPtr* outArrays, int count,
+			const NoiseExecutionContext& context
+		) const final {
+			if (count == 0) return;
+
+			// Every array has the same type, so the first one picks the implementation.
+			std::visit([&](auto&& ptr) {
+				using TOut = std::remove_pointer_t<std::decay_t<decltype(ptr)>>;
+
+				switch (regions[0].GetDimensions()) {
+				case 2:
+					ProcessBatchSIMDImpl<2, TOut>(regions, outArrays, count, context);
+					break;
+				case 3:
+					ProcessBatchSIMDImpl<3, TOut>(regions, outArrays, count, context);
+					break;
+				default:
+					break;
+				}
+				}, outArrays[0]);
+		}
+
+		virtual void ProcessViewSIMD(
+			const NoiseSamplingParameters<B, F>& params, const VarView& outView, int begin, 
+			int end, const NoiseExecutionContext& context
+		) const final {
+			std::visit([&](auto&& view) {
+				using TOut = std::remove_pointer_t<decltype(view.Data)>;
+
+				switch (params.GetDimensions()) {
+				case 2:
+					ProcessViewGridSIMD<2, TOut>(params, view, begin, end, context);
+					break;
+				case 3:
+					ProcessViewGridSIMD<3, TOut>(params, view, begin, end, context);
+					break;
+				default: {
+					// Written as 0, same as ProcessSIMD().
+					const D<B, F> d;
+					ScratchBuffer<B, F> values;
+					AlignedArray<TOut> converted(NoiseBlock<B, F>::Size);
+
+					ForEachVector<B, F>(NoiseBlock<B, F>::Size, [&](int i) {
+						hn::Store(Zero<vec>(), d, values + i);
+					});
+
+					for (int i = begin; i < end; i += NoiseBlock<B, F>::Size) {
+						const int count = std::min(NoiseBlock<B, F>::Size, end - i);
+						StoreView(values, i, count, params, view, converted.GetPtr());
+					}
+					break;
+				}
+				}
+				}, outView);
+		}
+
+		virtual void ProcessOutputsSIMD(
+			const NoiseSamplingParameters<B, F>& params, const VarPtr* outArrays, int outputCount,
+			int begin, int end, const NoiseExecutionContext& context
+		) const final {
+			if (outputCount == 0) return;
+
+			// Every array has the same type, so the first one picks the implementation.
+			std::visit([&](auto&& ptr) {
+				using TOut = std::remove_pointer_t<std::decay_t<decltype(ptr)>>;
+
+				switch (params.GetDimensions()) {
+				case 2:
+					ProcessOutputsGridSIMD<2, TOut>(
+						params, outArrays, outputCount, begin, end, context);
+					break;
+				case 3:
+					ProcessOutputsGridSIMD<3, TOut>(
+						params, outArrays, outputCount, begin, end, context);
+					break;
+				default:
+					// Written as 0, same as ProcessSIMD().
+					for (int j = 0; j < outputCount; ++j) {
+						ProcessSIMD(params, outArrays[j], begin, end, context, nullptr);
+					}
+					break;
+				}
+				}, outArrays[0]);
+		}
+
+		// Helper for nodes that compute each vector independently. Writes func2D(x, y) or 
+		// func3D(x, y, z) of every vector of the block to out. 
+		template <typename Func2D, typename Func3D>
+		HWY_INLINE static void EvaluateVectors(
+			const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out, 
+			Func2D&& func2D, Func3D&& func3D
+		) {
+			const D<B, F> d;
+
+			if (block.Is3D()) {
+				ForEachVector<B, F>(block.Count, [&](int i) {
+					vec x = hn::Load(d, block.X + i);
+					vec y = hn::Load(d, block.Y + i);
+					vec z = hn::Load(d, block.Z + i);
+					hn::Store(func3D(x, y, z), d, out + i);
+				});
+			}
+			else {
+				ForEachVector<B, F>(block.Count, [&](int i) {
+					vec x = hn::Load(d, block.X + i);
+					vec y = hn::Load(d, block.Y + i);
+					hn::Store(func2D(x, y), d, out + i);
+				});
+			}
+		}
+
 	private:
 
 		template <typename TOut>
-		void ProcessSIMDImpl(NoiseSamplingParameters<B, F> params, TOut* HWY_RESTRICT outArray) {
-			// Number of output samples
-			size_t count = params.TotalSize();
-
-			// laneCount might not evenly fit into X*Y(*Z) = count. We also don't want to write past
-			// the size of the input array. So, we have a normal loop and a "remainder" write. The
-			// normal loop writes normally, but the remainder write is to only write enough to fill
-			// the array and not more. 
-			const size_t laneCount = hn::Lanes(D<B, F>());
-			size_t remainderStoreSize = count % laneCount;
-
-			// We're always going to do the "remainder" store operation. If the lastWriteSize is 0,
-			// just take all valid entries from the vector, and turn those into "remainder" stores. 
-			if (remainderStoreSize == 0) remainderStoreSize = laneCount;
-
-			// Shifts the sample to fit fully into TOut.
-			auto shiftLambda = [](vec sample) {
-				// Shifts the fractional part of the sample to the left, then additional shift to
-				// account for the difference in size between input and output.
-				constexpr int shift = (int(B) - int(F)) - 
-					(int(sizeof(UT<B, F>)) - int(sizeof(TOut))) * 8;
-
-				if constexpr (shift < 0) {
-					return hn::ShiftRight<-shift>(sample);
-				}
-				else if constexpr (shift > 0) {
-					return hn::ShiftLeft<shift>(sample);
+		void ProcessSIMDImpl(
+			const NoiseSamplingParameters<B, F>& params, TOut* HWY_RESTRICT outArray, int begin, 
+			int end, const NoiseExecutionContext& context, NoiseSampleStats<B, F>* stats
+		) const {
+			// The dimension specific loop is selected once, rather than for every block.
+			switch (params.GetDimensions()) {
+			case 2:
+				ProcessGridSIMD<2>(params, outArray, begin, end, context, stats);
+				break;
+			case 3:
+				ProcessGridSIMD<3>(params, outArray, begin, end, context, stats);
+				break;
+			default: {
+				// Other dimensions can't be sampled, and are written as 0.
+				const D<B, F> d;
+				ScratchBuffer<B, F> values;
+
+				ForEachVector<B, F>(NoiseBlock<B, F>::Size, [&](int i) {
+					hn::Store(Zero<vec>(), d, values + i);
+				});
+
+				for (int i = begin; i < end; i += NoiseBlock<B, F>::Size) {
+					const int count = std::min(NoiseBlock<B, F>::Size, end - i);
+					StoreValues(values, count, outArray + i);
+					if (stats) AccumulateStats(values, i, count, *stats);
+				}
+				break;
+			}
+			}
+		}
+
+		template <size_t Dimensions, typename TOut>
+		void ProcessGridSIMD(
+			const NoiseSamplingParameters<B, F>& params, TOut* HWY_RESTRICT outArray, int begin, 
+			int end, const NoiseExecutionContext& context, NoiseSampleStats<B, F>* stats
+		) const {
+			ScratchBuffer<B, F> x, y, z, values;
+			const T<B, F>* blockZ = (Dimensions == 3) ? z.Get() : nullptr;
+			const bool isStream = IsStreamed(outArray + begin, params.TotalSize() * sizeof(TOut));
+
+			for (int blockBegin = begin; blockBegin < end; blockBegin += NoiseBlock<B, F>::Size) {
+				const int count = std::min(NoiseBlock<B, F>::Size, end - blockBegin);
+
+				GenerateGridCoordinates<B, F, Dimensions>(params, blockBegin, count, x, y, z);
+				Evaluate(NoiseBlock<B, F>{ x, y, blockZ, count, context, blockBegin }, values);
+				StoreValues(values, count, outArray + blockBegin, StoreMode::Saturate, isStream);
+
+				// The block's values are still in L1, so this doesn't add a pass over memory.
+				if (stats) AccumulateStats(values, blockBegin, count, *stats);
+			}
+
+			if (isStream) hwy::FlushStream();
+		}
+
+		// Same as ProcessGridSIMD(), but writes through a view. Dense views are written to 
+		// directly. Others take the values of a block from a small buffer that stays in L1, 
+		// straight into their rows. 
+		template <size_t Dimensions, typename TOut>
+		void ProcessViewGridSIMD(
+			const NoiseSamplingParameters<B, F>& params, const NoiseOutputView<TOut>& view,
+			int begin, int end, const NoiseExecutionContext& context
+		) const {
+			ScratchBuffer<B, F> x, y, z, values;
+			const T<B, F>* blockZ = (Dimensions == 3) ? z.Get() : nullptr;
+
+			const NoiseOutputView<TOut> dense = NoiseOutputView<TOut>::Dense(view.Data, params);
+			TOut* denseOut = view.Data + view.ChannelOffset;
+			const bool isDense = view.IsRowContiguous() && 
+				view.RowPitch == dense.RowPitch && 
+				(Dimensions < 3 || view.SlicePitch == dense.SlicePitch);
+			const bool isStream = isDense && 
+				IsStreamed(denseOut + begin, params.TotalSize() * sizeof(TOut));
+
+			AlignedArray<TOut> converted;
+			if (!isDense) converted.Reallocate(NoiseBlock<B, F>::Size);
+
+			for (int blockBegin = begin; blockBegin < end; blockBegin += NoiseBlock<B, F>::Size) {
+				const int count = std::min(NoiseBlock<B, F>::Size, end - blockBegin);
+
+				GenerateGridCoordinates<B, F, Dimensions>(params, blockBegin, count, x, y, z);
+				Evaluate(NoiseBlock<B, F>{ x, y, blockZ, count, context, blockBegin }, values);
+
+				if (isDense) {
+					StoreValues(values, count, denseOut + blockBegin, view.Mode, isStream);
 				}
 				else {
-					return sample;
+					StoreView(values, blockBegin, count, params, view, converted.GetPtr());
 				}
-			};
-			
-			// Write every chunk but the last one to the array
-			int i = 0;
-			for (; i < int(count) - int(laneCount); i += laneCount) {
-				vec result = Sample(i, params);
-				result = shiftLambda(result);
-				Store<T<B, F>, TOut>(result, outArray + i);
 			}
 
-			// Write last chunk to the array
-			vec result = Sample(i, params);
-			result = shiftLambda(result);
-			Store<T<B, F>, TOut>(result, outArray + i);
+			if (isStream) hwy::FlushStream();
 		}
 
-		// TODO: Make this function more generic
-		vec Sample(size_t i, NoiseSamplingParameters<B, F> params) {
+		// Same as ProcessGridSIMD(), but every block is evaluated once for all the outputs. 
+		template <size_t Dimensions, typename TOut>
+		void ProcessOutputsGridSIMD(
+			const NoiseSamplingParameters<B, F>& params, const VarPtr* outArrays, int outputCount,
+			int begin, int end, const NoiseExecutionContext& context
+		) const {
+			ScratchBuffer<B, F> x, y, z;
+			const T<B, F>* blockZ = (Dimensions == 3) ? z.Get() : nullptr;
 
-			auto GetOffsetLambda = [&](vec indices) {
-				return FPMul<B, F>(hn::ShiftLeft<F>(indices), params.Spacing);
+			std::vector<TOut*> outputArrays(outputCount);
+			std::vector<T<B, F>*> values(outputCount);
+			bool isStream = true;
+
+			for (int j = 0; j < outputCount; ++j) {
+				outputArrays[j] = std::get<TOut*>(outArrays[j]);
+				values[j] = BlockScratch<B, F>::Push();
+
+				isStream &= IsStreamed(
+					outputArrays[j] + begin, params.TotalSize() * sizeof(TOut) * outputCount);
+			}
+
+			for (int blockBegin = begin; blockBegin < end; blockBegin += NoiseBlock<B, F>::Size) {
+				const int count = std::min(NoiseBlock<B, F>::Size, end - blockBegin);
+
+				GenerateGridCoordinates<B, F, Dimensions>(params, blockBegin, count, x, y, z);
+				EvaluateOutputs(
+					NoiseBlock<B, F>{ x, y, blockZ, count, context, blockBegin }, values.data());
+
+				for (int j = 0; j < outputCount; ++j) {
+					StoreValues(values[j], count, outputArrays[j] + blockBegin, 
+						StoreMode::Saturate, isStream);
+				}
+			}
+
+			if (isStream) hwy::FlushStream();
+
+			for (int j = 0; j < outputCount; ++j) {
+				BlockScratch<B, F>::Pop();
+			}
+		}
+
+		// Packs the samples of consecutive regions into the same blocks, so that small regions 
+		// don't each evaluate a mostly empty block. Regions start on vector boundaries within a 
+		// block, which keeps coordinates and values aligned. So a region wastes at most the 
+		// lanes of its last vector (none for sizes that are a multiple of the lane count). 
+		template <size_t Dimensions, typename TOut>
+		void ProcessBatchSIMDImpl(
+			const NoiseSamplingParameters<B, F>* regions, const VarPtr* outArrays, int count,
+			const NoiseExecutionContext& context
+		) const {
+			const int laneCount = hn::Lanes(D<B, F>());
+			ScratchBuffer<B, F> x, y, z, values;
+			const T<B, F>* blockZ = (Dimensions == 3) ? z.Get() : nullptr;
+
+			// Samples of a region within the current block
+			struct Segment
+			{
+				TOut* Out;
+				int Offset;
+				int Count;
 			};
 
-			size_t dimensions = params.GetDimensions();
+			std::vector<Segment> segments;
+			int filled = 0;
+
+			auto FlushLambda = [&]() {
+				if (filled == 0) return;
+
+				// Packed blocks span several grids, so they are off the grid.
+				Evaluate(NoiseBlock<B, F>{ x, y, blockZ, filled, context }, values);
+
+				for (const Segment& segment : segments) {
+					StoreValues(values + segment.Offset, segment.Count, segment.Out);
+				}
 
-			if (dimensions == 2) {
-				vec idX, idY;
-				VUnravel(i, params.Size(0), params.Size(1), idX, idY);
-				vec sampleX = FPAdd<B, F>(params.Start(0), GetOffsetLambda(idX));
-				vec sampleY = FPAdd<B, F>(params.Start(1), GetOffsetLambda(idY));
-				return this->operator()(sampleX, sampleY);
+				segments.clear();
+				filled = 0;
+			};
+
+			for (int r = 0; r < count; ++r) {
+				const NoiseSamplingParameters<B, F>& region = regions[r];
+				assert(region.GetDimensions() == Dimensions);
+
+				TOut* outArray = std::get<TOut*>(outArrays[r]);
+				const int total = region.TotalSize();
+
+				for (int begin = 0; begin < total;) {
+					const int take = std::min(NoiseBlock<B, F>::Size - filled, total - begin);
+
+					GenerateGridCoordinates<B, F, Dimensions>(
+						region, begin, take, x + filled, y + filled, z + filled);
+					segments.push_back(Segment{ outArray + begin, filled, take });
+
+					begin += take;
+					filled += (take + laneCount - 1) / laneCount * laneCount;
+
+					if (filled == NoiseBlock<B, F>::Size) {
+						FlushLambda();
+					}
+				}
 			}
 
-			else if (dimensions == 3) {
-				vec idX, idY, idZ;
-				VUnravel(i, params.Size(0), params.Size(1), params.Size(2), idX, idY, idZ);
-				vec sampleX = FPAdd<B, F>(params.Start(0), GetOffsetLambda(idX));
-				vec sampleY = FPAdd<B, F>(params.Start(1), GetOffsetLambda(idY));
-				vec sampleZ = FPAdd<B, F>(params.Start(2), GetOffsetLambda(idZ));
-				return this->operator()(sampleX, sampleY, sampleZ);
+			FlushLambda();
+		}
+
+		template <typename TOut>
+		void ProcessPointsSIMDImpl(
+			const T<B, F>* px, const T<B, F>* py, const T<B, F>* pz, int count, 
+			TOut* HWY_RESTRICT outArray, const NoiseExecutionContext& context
+		) const {
+			const int laneCount = hn::Lanes(D<B, F>());
+			ScratchBuffer<B, F> x, y, z, values;
+
+			for (int blockBegin = 0; blockBegin < count; blockBegin += NoiseBlock<B, F>::Size) {
+				const int blockCount = std::min(NoiseBlock<B, F>::Size, count - blockBegin);
+				const int paddedCount = (blockCount + laneCount - 1) / laneCount * laneCount;
+
+				// Points aren't padded, so the last vector is padded with the last point. That way
+				// every lane has coordinates within the bounds. 
+				auto CopyLambda = [&](const T<B, F>* points, T<B, F>* coordinates) {
+					std::copy_n(points + blockBegin, blockCount, coordinates);
+					std::fill(
+						coordinates + blockCount, coordinates + paddedCount, 
+						points[blockBegin + blockCount - 1]
+					);
+				};
+
+				CopyLambda(px, x);
+				CopyLambda(py, y);
+				if (pz) CopyLambda(pz, z);
+
+				const T<B, F>* blockZ = pz ? z.Get() : nullptr;
+				Evaluate(NoiseBlock<B, F>{ x, y, blockZ, blockCount, context }, values);
+				StoreValues(values, blockCount, outArray + blockBegin);
 			}
+		}
+
+		// Converts the count values of the samples starting at flattened index begin to TOut, and
+		// writes them through the view. converted holds a block of TOut. 
+		template <typename TOut>
+		static void StoreView(
+			const T<B, F>* HWY_RESTRICT values, int begin, int count, 
+			const NoiseSamplingParameters<B, F>& params, const NoiseOutputView<TOut>& view,
+			TOut* HWY_RESTRICT converted
+		) {
+			StoreValues(values, count, converted, view.Mode);
+
+			const int sizeX = params.Size(0);
+			const int sizeY = (params.GetDimensions() > 1) ? params.Size(1) : 1;
+			int x = begin % sizeX;
+			int y = (begin / sizeX) % sizeY;
+			int z = begin / sizeX / sizeY;
+
+			// A run of samples within a row at a time
+			for (int i = 0; i < count;) {
+				const int n = std::min(count - i, sizeX - x);
+				TOut* out = view.At(x, y, z);
+
+				if (view.IsRowContiguous()) {
+					std::copy_n(converted + i, n, out);
+				}
+				else if (!view.HasPad) {
+					for (int e = 0; e < n; ++e) {
+						std::fill_n(out + e * view.ElementStride, view.Channels, converted[i + e]);
+					}
+				}
+				else {
+					// Whole elements, so write-only memory (e.g. a locked texture) is only written.
+					TOut* element = out - view.ChannelOffset;
+					const int channelEnd = view.ChannelOffset + view.Channels;
+
+					for (int e = 0; e < n; ++e, element += view.ElementStride) {
+						for (int c = 0; c < view.ElementStride; ++c) {
+							const bool isChannel = (c >= view.ChannelOffset && c < channelEnd);
+							element[c] = isChannel ? converted[i + e] : view.Pad;
+						}
+					}
+				}
+
+				i += n;
+				x = 0;
+
+				if (++y == sizeY) {
+					y = 0;
+					++z;
+				}
+			}
+		}
+
+		// Adds the count values of the samples starting at flattened index begin to stats. 
+		static void AccumulateStats(
+			const T<B, F>* HWY_RESTRICT values, int begin, int count, NoiseSampleStats<B, F>& stats
+		) {
+			using uvec = UV<B, F>;
+			const D<B, F> d;
+			const UD<B, F> du;
+			const int laneCount = hn::Lanes(d);
+
+			vec min = hn::Set(d, stats.Min.ToRaw());
+			vec max = hn::Set(d, stats.Max.ToRaw());
+			const vec threshold = hn::Set(d, stats.Threshold.ToRaw());
+			const vec lastBucket = hn::Set(d, NoiseSampleStats<B, F>::HistogramSize - 1);
+			uvec index = hn::Iota(du, begin);
+			uvec checksum = hn::Zero(du);
+			size_t aboveCount = 0;
+
+			HWY_ALIGN T<B, F> buckets[hn::MaxLanes(d)];
+
+			for (int i = 0; i < count; i += laneCount) {
+				const int n = std::min(laneCount, count - i);
+				const M<B, F> mask = hn::FirstN(d, n);
+				const vec value = hn::Load(d, values + i);
+
+				// Lanes past count keep the current min / max, and hash to 0. 
+				min = hn::Min(min, hn::IfThenElse(mask, value, min));
+				max = hn::Max(max, hn::IfThenElse(mask, value, max));
+				aboveCount += hn::CountTrue(d, hn::And(mask, hn::Ge(value, threshold)));
+
+				const uvec hash = Hash(index, hn::BitCast(du, value));
+				checksum = hn::Add(checksum, hn::IfThenElseZero(hn::RebindMask(du, mask), hash));
+				index = hn::Add(index, hn::Set(du, laneCount));
 
+				// [0, 1) is split into 2^8 buckets, so the bucket is the top 8 fractional bits.
+				vec bucket = value;
+
+				if constexpr (F > 8) {
+					bucket = hn::ShiftRight<int(F) - 8>(bucket);
+				}
+				else if constexpr (F < 8) {
+					bucket = hn::ShiftLeft<8 - int(F)>(bucket);
+				}
+
+				hn::Store(hn::Min(hn::Max(bucket, Zero<vec>()), lastBucket), d, buckets);
+
+				for (int lane = 0; lane < n; ++lane) {
+					++stats.Histogram[buckets[lane]];
+				}
+			}
+
+			// Summed in 64 bits, since a block of raw values can overflow the fixed point type.
+			const hn::ScalableTag<int64_t> dw;
+			const hn::Rebind<T<B, F>, decltype(dw)> dn;
+			const int wideCount = hn::Lanes(dw);
+			auto sum = hn::Zero(dw);
+
+			for (int i = 0; i < count; i += wideCount) {
+				const size_t n = std::min(wideCount, count - i);
+				sum = hn::Add(sum, hn::PromoteTo(dw, hn::LoadN(dn, values + i, n)));
+			}
+
+			using fp = FixedPoint<B, F>;
+			stats.Min = fp::FromBase(hn::ReduceMin(d, min));
+			stats.Max = fp::FromBase(hn::ReduceMax(d, max));
+			stats.Sum += hn::ReduceSum(dw, sum);
+			stats.Count += count;
+			stats.AboveCount += int(aboveCount);
+			stats.Checksum += uint32_t(hn::ReduceSum(du, checksum));
+		}
+
+		// True if the samples written to out are worth writing with non-temporal stores. Outputs
+		// larger than the cache would only evict the nodes' caches, since nothing reads them back
+		// while sampling. 
+		static bool IsStreamed(const void* out, size_t bytes) {
+			return bytes > NodeBase<B, F>::StreamingStoreSize && 
+				reinterpret_cast<uintptr_t>(out) % HWY_ALIGNMENT == 0;
+		}
+
+		// Converts count values to TOut, and writes them to outArray. Fixed point values in 
+		// [0, 1) are scaled to the full range of integer outputs (the positive range of signed 
+		// ones). Float outputs hold the values themselves. 
+		// If isStream, outArray must be vector-aligned, and hwy::FlushStream() must be called
+		// once done. 
+		template <typename TOut>
+		static void StoreValues(
+			const T<B, F>* HWY_RESTRICT values, int count, TOut* HWY_RESTRICT outArray,
+			StoreMode mode = StoreMode::Saturate, bool isStream = false
+		) {
+			// The mode is picked once per block, rather than per vector.
+			switch (mode) {
+			case StoreMode::Round:
+				StoreValuesImpl<TOut, StoreMode::Round>(values, count, outArray, isStream);
+				break;
+			case StoreMode::Truncate:
+				StoreValuesImpl<TOut, StoreMode::Truncate>(values, count, outArray, isStream);
+				break;
+			default:
+				StoreValuesImpl<TOut, StoreMode::Saturate>(values, count, outArray, isStream);
+				break;
+			}
+		}
+
+		template <typename TOut, StoreMode Mode>
+		static void StoreValuesImpl(
+			const T<B, F>* HWY_RESTRICT values, int count, TOut* HWY_RESTRICT outArray, 
+			bool isStream
+		) {
+			// laneCount might not evenly fit into count. We also don't want to write past count,
+			// since another tile may own the samples after it. So, we have a normal loop and a 
+			// "remainder" write. The normal loop writes whole vectors, but the remainder write is
+			// to only write enough to fill the range and not more. 
+			const D<B, F> d;
+			const int laneCount = hn::Lanes(d);
+
+			// Moves the fractional part of the sample to the top bits of TOut (below the sign 
+			// bit of signed types). Floats only drop the fixed point scale. 
+			constexpr int shift = hwy::IsFloat<TOut>() ? -int(F) : 
+				int(sizeof(TOut)) * 8 - (hwy::IsSigned<TOut>() ? 1 : 0) - int(F);
+
+			// Write every full vector to the array
+			int i = 0;
+
+			if (isStream) {
+				for (; i + laneCount <= count; i += laneCount) {
+					StoreStream<T<B, F>, TOut, Mode, shift>(hn::Load(d, values + i), outArray + i);
+				}
+			}
 			else {
-				return Zero<vec>();
+				for (; i + laneCount <= count; i += laneCount) {
+					Store<T<B, F>, TOut, Mode, shift>(hn::Load(d, values + i), outArray + i);
+				}
+			}
+
+			// Write the remainder to the array
+			if (i < count) {
+				StoreN<T<B, F>, TOut, Mode, shift>(
+					hn::Load(d, values + i), outArray + i, count - i);
 			}
 		}
 	};
+
+	// Binds a node to the context it is sampled with, so that it can be passed into the noise
+	// functions that take a generic sampler (Fractal, Warp, Tree, etc...). 
+	template <size_t B, size_t F>
+	struct NodeSampler
+	{
+		const NodeBaseSIMD<B, F>& Node;
+		const NoiseExecutionContext& Context;
+
+		V<B, F> operator()(V<B, F> x, V<B, F> y) const {
+			return Node(x, y, Context);
+		}
+
+		V<B, F> operator()(V<B, F> x, V<B, F> y, V<B, F> z) const {
+			return Node(x, y, z, Context);
+		}
+	};
 }
 HWY_AFTER_NAMESPACE();
 
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_NODES_BLOCK_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_NODES_BLOCK_SIMD_H_
+#undef NOISEGRAPH_NODES_BLOCK_SIMD_H_
+#else
+#define NOISEGRAPH_NODES_BLOCK_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "AlignedArray.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "NoiseExecutionContext.h"
+#include <vector>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// A span of sample coordinates in SoA layout, which nodes evaluate in a single call.
+	//
+	// Buffers are padded to whole vectors. Nodes read and write every vector that overlaps
+	// [0, Count), so values past Count are garbage but never out of bounds.
+	template <size_t B, size_t F>
+	struct NoiseBlock
+	{
+		// Max number of samples in a block. Large enough that one virtual call per node is
+		// negligible, small enough that a node's intermediate buffers stay in L1/L2.
+		static constexpr int Size = 512;
+
+		const T<B, F>* X;
+		const T<B, F>* Y;
+		const T<B, F>* Z;	// nullptr for 2D blocks
+		int Count;
+		const NoiseExecutionContext& Context;
+
+		// Flattened index of the first sample within the sampled grid, or -1 if the block's 
+		// coordinates aren't on the grid (e.g. they were warped). 
+		int Begin = -1;
+
+		bool Is3D() const {
+			return Z != nullptr;
+		}
+
+		// Same samples, at different coordinates. Used by nodes that transform the domain.
+		// The new coordinates are no longer on the grid.
+		NoiseBlock WithCoordinates(const T<B, F>* x, const T<B, F>* y, const T<B, F>* z) const {
+			return NoiseBlock{ x, y, z, Count, Context };
+		}
+	};
+
+	// Per-thread stack of block sized buffers for intermediate values.
+	// Nested nodes take and return buffers in LIFO order (through ScratchBuffer), so after the
+	// first few blocks, evaluation doesn't allocate.
+	template <size_t B, size_t F>
+	class BlockScratch
+	{
+	public:
+		static T<B, F>* Push() {
+			Arena& arena = GetArena();
+
+			if (arena.Top == arena.Buffers.size()) {
+				arena.Buffers.emplace_back(NoiseBlock<B, F>::Size);
+			}
+
+			return arena.Buffers[arena.Top++].GetPtr();
+		}
+
+		static void Pop() {
+			--GetArena().Top;
+		}
+
+	private:
+		struct Arena
+		{
+			std::vector<AlignedArray<T<B, F>>> Buffers;
+			size_t Top = 0;
+		};
+
+		static Arena& GetArena() {
+			static thread_local Arena arena;
+			return arena;
+		}
+	};
+
+	// Scoped scratch buffer of NoiseBlock::Size values.
+	template <size_t B, size_t F>
+	class ScratchBuffer
+	{
+	public:
+		ScratchBuffer() : Ptr(BlockScratch<B, F>::Push()) {}
+		~ScratchBuffer() { BlockScratch<B, F>::Pop(); }
+
+		ScratchBuffer(const ScratchBuffer&) = delete;
+		ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+		operator T<B, F>* () const {
+			return Ptr;
+		}
+
+		T<B, F>* Get() const {
+			return Ptr;
+		}
+
+	private:
+		T<B, F>* Ptr;
+	};
+
+	// Calls func(i) with the index of every vector that overlaps [0, count).
+	template <size_t B, size_t F, typename Func>
+	HWY_INLINE void ForEachVector(int count, Func&& func) {
+		const int laneCount = hn::Lanes(D<B, F>());
+
+		for (int i = 0; i < count; i += laneCount) {
+			func(i);
+		}
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
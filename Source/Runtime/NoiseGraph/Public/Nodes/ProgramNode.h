@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_NODES_PROGRAM_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_NODES_PROGRAM_SIMD_H_
+#undef NOISEGRAPH_NODES_PROGRAM_SIMD_H_
+#else
+#define NOISEGRAPH_NODES_PROGRAM_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Nodes/NodeBaseSIMD.h"
+#include "Program/NoiseProgram.h"
+#include "Program/NoiseInterpreter.h"
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Compiled version of a node graph. The graph is lowered into a NoiseProgram for 2D and 3D
+	// on construction, and sampling runs the program instead of walking the nodes.
+	// Output is bit-identical to sampling the root node directly.
+	//
+	// When sampling a 3D grid, the values that don't depend on z (e.g. the 2D base of a 
+	// heightmap) are computed once per XY column in PreProcessGrid(), and loaded for every sample
+	// of the column. 
+	//
+	// When sampling a grid, the lattice values of noises sampled along its axes (e.g. Perlin's
+	// floors and fades) are also computed once per row and column of the grid in
+	// PreProcessGrid(), see NoiseProgram::BuildGrid().
+	//
+	// A program can be built from several roots, with an output per root (see ProcessOutputs()).
+	// The roots are compiled together, so the subgraphs they share are evaluated once per block.
+	// Evaluate() only writes the first output. 
+	template <size_t B, size_t F>
+	class ProgramNode : public NodeBaseSIMD<B, F>
+	{
+	public:
+		ProgramNode(std::shared_ptr<NodeBaseSIMD<B, F>> root) :
+			ProgramNode(std::vector<std::shared_ptr<NodeBaseSIMD<B, F>>>{ root }) {}
+
+		ProgramNode(std::vector<std::shared_ptr<NodeBaseSIMD<B, F>>> roots) :
+			Roots(std::move(roots)),
+			Root(Roots.at(0)),
+			Program2D(NoiseProgramBuilder<B, F>::Build(GetRootPointers(), 2)),
+			Program3D(NoiseProgramBuilder<B, F>::Build(GetRootPointers(), 3)),
+			Program3DPlanar(NoiseProgramBuilder<B, F>::Build(GetRootPointers(), 3, true)) {}
+
+		virtual ~ProgramNode() = default;
+
+		// Caches are still built by the nodes.
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			for (const std::shared_ptr<NodeBaseSIMD<B, F>>& root : Roots) {
+				root->PreProcess(bounds, context);
+			}
+		}
+
+		virtual void PreProcessGrid(
+			const NoiseSamplingParameters<B, F>& params, NoiseExecutionContext& context
+		) const override {
+			for (const std::shared_ptr<NodeBaseSIMD<B, F>>& root : Roots) {
+				root->PreProcessGrid(params, context);
+			}
+
+			const int dimensions = params.GetDimensions();
+
+			if (dimensions != 2 && dimensions != 3) {
+				return;
+			}
+
+			GridState& state = context.GetOrCreateState<GridState>(this);
+			const NoiseProgram<B, F>& program = (dimensions == 2) ? Program2D : Program3DPlanar;
+			program.BuildGrid(params, state.Grid);
+			state.IsValid = true;
+
+			if (dimensions != 3 || !Program3DPlanar.Plane) {
+				return;
+			}
+
+			const NoiseProgram<B, F>& planeProgram = *Program3DPlanar.Plane;
+
+			// XY plane of the grid. Flattened indices of the plane are the same as the indices
+			// of the grid's first z slice. 
+			NoiseSamplingParameters<B, F> planeParams(params.Spacing);
+			planeParams.Add(params.Start(0), params.Size(0));
+			planeParams.Add(params.Start(1), params.Size(1));
+
+			// Padded, since the last block writes whole vectors.
+			const int planeSize = planeParams.TotalSize();
+			const int paddedSize = planeSize + NoiseBlock<B, F>::Size;
+			state.Plane.Size = planeSize;
+			state.Plane.Values.resize(planeProgram.OutputCount);
+
+			for (AlignedArray<T<B, F>>& values : state.Plane.Values) {
+				values.EnsureSize(paddedSize);
+			}
+
+			NoiseProgramGrid<B, F> planeGrid;
+			planeProgram.BuildGrid(planeParams, planeGrid);
+
+			// The plane values don't depend on z, so any z works.
+			const D<B, F> d;
+			ScratchBuffer<B, F> x, y, z;
+			std::vector<T<B, F>*> outputs(planeProgram.OutputCount);
+
+			ForEachVector<B, F>(NoiseBlock<B, F>::Size, [&](int i) {
+				hn::Store(FPBroadcast<B, F>(params.Start(2)), d, z + i);
+			});
+
+			for (int begin = 0; begin < planeSize; begin += NoiseBlock<B, F>::Size) {
+				const int count = std::min(NoiseBlock<B, F>::Size, planeSize - begin);
+
+				GenerateGridCoordinates<B, F, 2>(planeParams, begin, count, x, y, nullptr);
+
+				for (int j = 0; j < planeProgram.OutputCount; ++j) {
+					outputs[j] = state.Plane.Values[j].GetPtr() + begin;
+				}
+
+				planeProgram.Run(NoiseBlock<B, F>{ x, y, z, count, context, begin },
+					outputs.data(), nullptr, &planeGrid);
+			}
+		}
+
+		virtual void PostProcess(NoiseExecutionContext& context) const override {
+			for (const std::shared_ptr<NodeBaseSIMD<B, F>>& root : Roots) {
+				root->PostProcess(context);
+			}
+
+			// The lattices and plane are only valid for the grid they were built with.
+			if (GridState* state = context.FindState<GridState>(this)) {
+				state->IsValid = false;
+			}
+		}
+
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			return Root->GetRange(bounds);
+		}
+
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			return Root->GetAxes(dimensions);
+		}
+
+		int GetOutputCount() const override {
+			return int(Roots.size());
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			if (Roots.size() == 1) {
+				EvaluateOutputs(block, &out);
+				return;
+			}
+
+			// The other outputs are computed anyway, so they still need somewhere to go.
+			std::vector<T<B, F>*> outputs(Roots.size());
+			outputs[0] = out;
+
+			for (size_t j = 1; j < outputs.size(); ++j) {
+				outputs[j] = BlockScratch<B, F>::Push();
+			}
+
+			EvaluateOutputs(block, outputs.data());
+
+			for (size_t j = 1; j < outputs.size(); ++j) {
+				BlockScratch<B, F>::Pop();
+			}
+		}
+
+		void EvaluateOutputs(
+			const NoiseBlock<B, F>& block, T<B, F>* const* outputs
+		) const override {
+			// Samples on the grid given to PreProcessGrid() can use its lattices, and load their
+			// column's values.
+			const GridState* state = (block.Begin >= 0) ?
+				block.Context.template FindState<GridState>(this) : nullptr;
+			const bool isOnGrid = state && state->IsValid &&
+				state->Grid.Params.GetDimensions() == (block.Is3D() ? 3 : 2);
+
+			if (!block.Is3D()) {
+				Program2D.Run(block, outputs, nullptr, isOnGrid ? &state->Grid : nullptr);
+			}
+			else if (isOnGrid) {
+				Program3DPlanar.Run(block, outputs, &state->Plane, &state->Grid);
+			}
+			else {
+				Program3D.Run(block, outputs, nullptr);
+			}
+		}
+
+		// Programs inline into each other, rather than being called. Only the first output is 
+		// used by other nodes. 
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder,
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			return Root->Compile(builder, coords);
+		}
+
+		std::vector<std::shared_ptr<NodeBaseSIMD<B, F>>> Roots;
+		std::shared_ptr<NodeBaseSIMD<B, F>> Root;	// First of Roots
+
+	protected:
+		NoiseProgram<B, F> Program2D;
+		NoiseProgram<B, F> Program3D;
+		NoiseProgram<B, F> Program3DPlanar;	// Same as Program3D if nothing could be moved
+
+		std::vector<const NodeBaseSIMD<B, F>*> GetRootPointers() const {
+			std::vector<const NodeBaseSIMD<B, F>*> pointers;
+
+			for (const std::shared_ptr<NodeBaseSIMD<B, F>>& root : Roots) {
+				pointers.push_back(root.get());
+			}
+
+			return pointers;
+		}
+
+		// Lattices of the program sampling the grid (Program2D or Program3DPlanar), and values
+		// of Program3DPlanar's plane, built in PreProcessGrid().
+		struct GridState : NoiseNodeState
+		{
+			NoiseProgramGrid<B, F> Grid;
+			NoisePlane<B, F> Plane;
+			bool IsValid = false;
+		};
+	};
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
@@ -24,12 +24,24 @@ namespace SIMD::HWY_NAMESPACE
 	public:
 		RandomNode(FixedPoint<B, F> seed = FixedPoint<B, F>(0)) : Seed(seed) {}
 
-		vec operator()(vec x, vec y) override {
-			return Random<B, F>(x, y, Seed);
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			return NoiseRange<B, F>::Unit();
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			return Random<B, F>(x, y, z, Seed);
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			this->EvaluateVectors(block, out,
+				[&](vec x, vec y) { return Random<B, F>(x, y, Seed); },
+				[&](vec x, vec y, vec z) { return Random<B, F>(x, y, z, Seed); }
+			);
+		}
+
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			return builder.EmitSample(NoiseOp::Random, coords, Seed);
 		}
 
 		FixedPoint<B, F> Seed;
@@ -0,0 +1,261 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NODEGRAPH_NODES_RESAMPLE_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NODEGRAPH_NODES_RESAMPLE_SIMD_H_
+#undef NODEGRAPH_NODES_RESAMPLE_SIMD_H_
+#else
+#define NODEGRAPH_NODES_RESAMPLE_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Nodes/NodeBaseSIMD.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "AlignedArray.h"
+#include <bit>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Samples the base on a coarse lattice, and interpolates between the lattice points. 
+	// For low frequency noise (e.g. continents, biomes), which barely changes between samples. 
+	//
+	// The lattice is sampled in PreProcess(), over the bounds. Lattice points are at multiples of
+	// the stride, so neighbouring regions share their points and match at their borders. Samples
+	// outside of the bounds sample the base at their lattice points instead.
+	// Interpolation is bilinear / trilinear in fixed point, so it's the same on every target.
+	// The stride is rounded to a power of two, so that finding the cell of a sample is a shift
+	// rather than a (bit-serial) fixed point division.
+	template <size_t B, size_t F>
+	class ResampleNode : public NodeBaseSIMD<B, F>
+	{
+		using fp = FixedPoint<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+		using vec = V<B, F>;
+	public:
+		ResampleNode(
+			std::shared_ptr<NodeBaseSIMD<B, F>> base,
+			fp stride = fp(8)
+		) :Base(base), Stride(fp::FromBase(T<B, F>(1) << GetStrideShift(stride))),
+			StrideShift(GetStrideShift(stride)) {}
+
+		virtual ~ResampleNode() = default;
+
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			State& state = context.GetOrCreateState<State>(this);
+			const size_t dimensions = bounds.size();
+			state.Dimensions = dimensions;
+
+			if (dimensions != 2 && dimensions != 3) {
+				Base->PreProcess(bounds, context);
+				return;
+			}
+
+			// Lattice covering the bounds, with a point on either side of every sample.
+			NoiseSamplingParameters<B, F> lattice(Stride);
+
+			for (size_t i = 0; i < dimensions; ++i) {
+				const fp start = Floor<B, F>(bounds[i].Start / Stride) * Stride;
+				const int cells = Ceil<B, F>((bounds[i].End - start) / Stride).ToInt();
+
+				state.Origin[i] = start;
+				state.Sizes[i] = cells + 2;
+				lattice.Add(start, cells + 2);
+			}
+
+			std::vector<NoiseSamplingBound<B, F>> latticeBounds = lattice.GetBounds();
+			for (NoiseSamplingBound<B, F>& bound : latticeBounds) {
+				bound.End -= Stride;
+			}
+
+			Base->PreProcess(latticeBounds, context);
+
+			// Padded, since the last block writes whole vectors.
+			const int total = lattice.TotalSize();
+			state.Values.EnsureSize(total + NoiseBlock<B, F>::Size);
+
+			ScratchBuffer<B, F> x, y, z;
+			const T<B, F>* blockZ = (dimensions == 3) ? z.Get() : nullptr;
+
+			for (int begin = 0; begin < total; begin += NoiseBlock<B, F>::Size) {
+				const int count = std::min(NoiseBlock<B, F>::Size, total - begin);
+
+				if (dimensions == 3) {
+					GenerateGridCoordinates<B, F, 3>(lattice, begin, count, x, y, z);
+				}
+				else {
+					GenerateGridCoordinates<B, F, 2>(lattice, begin, count, x, y, z);
+				}
+
+				Base->Evaluate(
+					NoiseBlock<B, F>{ x, y, blockZ, count, context }, 
+					state.Values.GetPtr() + begin
+				);
+			}
+		}
+
+		virtual void PostProcess(NoiseExecutionContext& context) const override {
+			Base->PostProcess(context);
+		}
+
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			// The lattice extends up to a stride past the bounds. Interpolation stays within its
+			// points, other than rounding.
+			std::vector<NoiseSamplingBound<B, F>> latticeBounds = bounds;
+
+			for (NoiseSamplingBound<B, F>& bound : latticeBounds) {
+				bound.Start -= Stride;
+				bound.End += Stride;
+			}
+
+			NoiseRange<B, F> range = Base->GetRange(latticeBounds);
+			if (range.IsUnbounded()) return range;
+
+			return range.Widen(fp::FromBase(4));
+		}
+
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			return Base->GetAxes(dimensions);
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			const D<B, F> d;
+			const State& state = block.Context.template GetState<State>(this);
+			const T<B, F>* values = state.Values.GetPtr();
+			assert(state.Dimensions == (block.Is3D() ? 3 : 2));
+
+			// Lattice cell of the coordinate on an axis, and the position within the cell. Returns
+			// false if any of the cells, or the cells after them, aren't in the lattice.
+			auto CellLambda = [&](vec coordinate, size_t axis, vec& cell, vec& t) {
+				// (coordinate - origin) / stride
+				vec position = FPSub<B, F>(coordinate, state.Origin[axis]);
+
+				if (StrideShift <= int(F)) {
+					position = hn::ShiftLeftSame(position, int(F) - StrideShift);
+				}
+				else {
+					position = hn::ShiftRightSame(position, StrideShift - int(F));
+				}
+
+				cell = hn::ShiftRight<F>(position);
+				t = FPSub<B, F>(position, hn::ShiftLeft<F>(cell));
+
+				return hn::AllTrue(d, hn::And(
+					hn::Gt(cell, hn::Set(d, -1)), hn::Lt(cell, hn::Set(d, state.Sizes[axis] - 1))
+				));
+			};
+
+			// Coordinate of the lattice point at cell on an axis.
+			auto PointLambda = [&](vec cell, size_t axis) {
+				return FPAdd<B, F>(hn::ShiftLeftSame(cell, StrideShift), state.Origin[axis]);
+			};
+
+			const int strideY = state.Sizes[0];
+			const int strideZ = state.Sizes[0] * state.Sizes[1];
+
+			// Bilinear interpolation of the XY cell at index
+			auto BilinearLambda = [&](vec index, vec tx, vec ty) {
+				vec v00 = hn::GatherIndex(d, values, index);
+				vec v10 = hn::GatherIndex(d, values + 1, index);
+				vec v01 = hn::GatherIndex(d, values + strideY, index);
+				vec v11 = hn::GatherIndex(d, values + strideY + 1, index);
+
+				return FPLerp<B, F>(FPLerp<B, F>(v00, v10, tx), FPLerp<B, F>(v01, v11, tx), ty);
+			};
+
+			// Same as BilinearLambda(), with the base sampled at the lattice points instead.
+			// Lattice points are at multiples of the stride whatever the origin, so this gives the
+			// same values as the lattice of a region that covers the samples.
+			auto BaseBilinearLambda = [&](vec cellX, vec cellY, vec z, vec tx, vec ty) {
+				const vec x0 = PointLambda(cellX, 0);
+				const vec x1 = PointLambda(sn::Add(cellX, 1), 0);
+				const vec y0 = PointLambda(cellY, 1);
+				const vec y1 = PointLambda(sn::Add(cellY, 1), 1);
+
+				auto SampleLambda = [&](vec x, vec y) {
+					return block.Is3D() ?
+						(*Base)(x, y, z, block.Context) : (*Base)(x, y, block.Context);
+				};
+
+				return FPLerp<B, F>(
+					FPLerp<B, F>(SampleLambda(x0, y0), SampleLambda(x1, y0), tx),
+					FPLerp<B, F>(SampleLambda(x0, y1), SampleLambda(x1, y1), tx),
+					ty
+				);
+			};
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				vec cellX, cellY, cellZ, tx, ty, tz;
+				bool isInLattice = CellLambda(hn::Load(d, block.X + i), 0, cellX, tx);
+				isInLattice &= CellLambda(hn::Load(d, block.Y + i), 1, cellY, ty);
+
+				if (block.Is3D()) {
+					isInLattice &= CellLambda(hn::Load(d, block.Z + i), 2, cellZ, tz);
+				}
+
+				// Vectors outside of the lattice (e.g. warped past the bounds PreProcess() was
+				// given) sample the base at their lattice points, like the lattice would have.
+				if (!isInLattice) {
+					if (block.Is3D()) {
+						const vec z0 = PointLambda(cellZ, 2);
+						const vec z1 = PointLambda(sn::Add(cellZ, 1), 2);
+						const vec lower = BaseBilinearLambda(cellX, cellY, z0, tx, ty);
+						const vec upper = BaseBilinearLambda(cellX, cellY, z1, tx, ty);
+						hn::Store(FPLerp<B, F>(lower, upper, tz), d, out + i);
+					}
+					else {
+						const vec z = Zero<vec>();
+						hn::Store(BaseBilinearLambda(cellX, cellY, z, tx, ty), d, out + i);
+					}
+					return;
+				}
+
+				vec index = sn::Add(sn::Mul(cellY, strideY), cellX);
+
+				if (block.Is3D()) {
+					index = sn::Add(sn::Mul(cellZ, strideZ), index);
+
+					vec lower = BilinearLambda(index, tx, ty);
+					vec upper = BilinearLambda(sn::Add(index, strideZ), tx, ty);
+					hn::Store(FPLerp<B, F>(lower, upper, tz), d, out + i);
+				}
+				else {
+					hn::Store(BilinearLambda(index, tx, ty), d, out + i);
+				}
+			});
+		}
+
+		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
+		FixedPoint<B, F> Stride;
+		int StrideShift;	// log2 of Stride's raw value
+
+	protected:
+		// log2 of the power of two nearest to the stride's raw value.
+		static int GetStrideShift(fp stride) {
+			const uint32_t raw = uint32_t(std::max(stride, fp::FromBase(1)).ToRaw());
+			int shift = std::bit_width(raw) - 1;
+
+			if (shift > 0 && (raw >> (shift - 1)) == 3) {
+				++shift;
+			}
+
+			return std::min(shift, int(B) - 2);
+		}
+
+		// Lattice built in PreProcess(). Kept in the context so it's reused between calls.
+		struct State : NoiseNodeState
+		{
+			size_t Dimensions = 0;
+			FixedPoint<B, F> Origin[3];
+			int Sizes[3] = { 0, 0, 0 };
+			AlignedArray<T<B, F>> Values;
+		};
+	};
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
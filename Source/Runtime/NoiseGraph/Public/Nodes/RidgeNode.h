@@ -24,22 +24,53 @@ namespace SIMD::HWY_NAMESPACE
 		RidgeNode(std::shared_ptr<NodeBaseSIMD<B, F>> base) :Base(base) {}
 		virtual ~RidgeNode() = default;
 
-		virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) override {
-			Base->PreProcess(bounds);
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			Base->PreProcess(bounds, context);
 		}
 
-		vec operator()(vec x, vec y) override {
-			// From [0, 1] to [-1, 1]
-			vec rescale = hn::ShiftRight<1>(FPAdd<B, F>(fpc::One, (*Base)(x, y)));
-			vec abs = hn::Abs(rescale);
-			return hn::Abs(rescale);
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			// |(1 + v) / 2|
+			NoiseRange<B, F> range = Base->GetRange(bounds);
+			if (range.IsUnbounded()) return range;
+
+			FixedPoint<B, F> lower = (fpc::One + range.Min) >> 1;
+			FixedPoint<B, F> upper = (fpc::One + range.Max) >> 1;
+
+			if (lower >= 0) {
+				return NoiseRange<B, F>{ lower, upper };
+			}
+			else if (upper <= 0) {
+				return NoiseRange<B, F>{ -upper, -lower };
+			}
+			else {
+				return NoiseRange<B, F>{ FixedPoint<B, F>(0), std::max(-lower, upper) };
+			}
+		}
+
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			return Base->GetAxes(dimensions);
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			const D<B, F> d;
+			Base->Evaluate(block, out);
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				// From [0, 1] to [-1, 1]
+				vec rescale = hn::ShiftRight<1>(FPAdd<B, F>(fpc::One, hn::Load(d, out + i)));
+				hn::Store(hn::Abs(rescale), d, out + i);
+			});
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			// From [0, 1] to [-1, 1]
-			vec rescale = hn::ShiftRight<1>(FPAdd<B, F>(fpc::One, (*Base)(x, y, z)));
-			vec abs = hn::Abs(rescale);
-			return hn::Abs(rescale);
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			return builder.Emit(NoiseOp::Ridge, { Base->Compile(builder, coords) });
 		}
 
 		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_NODES_SIMPLEX_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_NODES_SIMPLEX_SIMD_H_
+#undef NOISEGRAPH_NODES_SIMPLEX_SIMD_H_
+#else
+#define NOISEGRAPH_NODES_SIMPLEX_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Nodes/NodeBaseSIMD.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "Functions/Simplex.h"
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	template <size_t B, size_t F>
+	class SimplexNode : public NodeBaseSIMD<B, F>
+	{
+		using vec = V<B, F>;
+
+	public:
+		SimplexNode(FixedPoint<B, F> seed = FixedPoint<B, F>(0)) : Seed(seed) {}
+
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			return NoiseRange<B, F>::Unit();
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			this->EvaluateVectors(block, out,
+				[&](vec x, vec y) { return Simplex<B, F>(x, y, Seed); },
+				[&](vec x, vec y, vec z) { return Simplex<B, F>(x, y, z, Seed); }
+			);
+		}
+
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			return builder.EmitSample(NoiseOp::Simplex, coords, Seed);
+		}
+
+		FixedPoint<B, F> Seed;
+	};
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_NODES_STATIC_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_NODES_STATIC_SIMD_H_
+#undef NOISEGRAPH_NODES_STATIC_SIMD_H_
+#else
+#define NOISEGRAPH_NODES_STATIC_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Nodes/NodeBaseSIMD.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "NoiseTypeTraits.h"
+#include "Functions/StaticNoise.h"
+
+#include <memory>
+#include <utility>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Wraps a graph composed at compile time (see StaticNoise.h), or any other noise function,
+	// into a node. The whole graph is evaluated in a single inlined loop, with one virtual call
+	// per block.
+	//
+	// Like every SIMD node, it must be created from per-target code (e.g. through HWY_EXPORT and
+	// HWY_DYNAMIC_DISPATCH, like NoiseGraph.cpp does), then set as a UNoiseGraph's Output.
+	// It has no recipe, so graphs using it are built at runtime rather than cooked.
+	template <size_t B, size_t F, typename Func>
+		requires Noise<B, F, 2, const Func> && Noise<B, F, 3, const Func>
+	class StaticNode : public NodeBaseSIMD<B, F>
+	{
+		using vec = V<B, F>;
+
+	public:
+		StaticNode(Func func) : Function(std::move(func)) {}
+
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			return GetStaticNoiseRange<B, F>(Function);
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			this->EvaluateVectors(block, out,
+				[&](vec x, vec y) { return Function(x, y); },
+				[&](vec x, vec y, vec z) { return Function(x, y, z); }
+			);
+		}
+
+		const Func Function;
+	};
+
+	template <size_t B, size_t F, typename Func>
+	inline std::shared_ptr<NodeBaseSIMD<B, F>> MakeStaticNode(Func func) {
+		return std::make_shared<StaticNode<B, F, Func>>(std::move(func));
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
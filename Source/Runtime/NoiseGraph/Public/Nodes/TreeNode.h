@@ -31,20 +31,50 @@ namespace SIMD::HWY_NAMESPACE
 
 		virtual ~TreeNode() = default;
 
-		virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) override {
-			GetTreeCache<B, F, 2, NodeBaseSIMD<B, F>>(
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			// The cache samples the base at the cell points, which are at most the depth 0 padding
+			// (3 cells) + 1 cell away from the bounds. 
+			std::vector<NoiseSamplingBound<B, F>> baseBounds = bounds;
+
+			for (size_t i = 0; i < baseBounds.size(); ++i) {
+				baseBounds[i].Start -= 4;
+				baseBounds[i].End += 4;
+			}
+
+			Base->PreProcess(baseBounds, context);
+
+			State& state = context.GetOrCreateState<State>(this);
+			NodeSampler<B, F> base{ *Base, context };
+			GetTreeCache<B, F, 2, NodeSampler<B, F>>(
 				MathVector<fp, 2>(bounds[0].Start, bounds[1].Start), 
 				MathVector<fp, 2>(bounds[0].End, bounds[1].End),
-				*Base, Seed, Depth, Regularity, Pool
+				base, Seed, Depth, Regularity, state.Pool
 			);
 		}
 
-		vec operator()(vec x, vec y) override {
-			return Tree<B, F, NodeBaseSIMD<B, F>>(x, y, Depth, Pool);
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			// Distance to the closest branch, which is at most the distance to the point of the 
+			// sample's own depth 0 cell. 
+			return NoiseRange<B, F>{ fp(0), fp(2) };
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			return Zero<vec>();
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			// 3D is not implemented, and is always 0.
+			return (dimensions == 2) ? NoiseAxes::XY : NoiseAxes::None;
+		}
+
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			const TreeCacheAllocPool<B, F, 2>& pool =
+				block.Context.template GetState<State>(this).Pool;
+
+			this->EvaluateVectors(block, out,
+				[&](vec x, vec y) { return Tree<B, F, NodeSampler<B, F>>(x, y, Depth, pool); },
+				[&](vec x, vec y, vec z) { return Zero<vec>(); }
+			);
 		}
 
 		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
@@ -53,7 +83,11 @@ namespace SIMD::HWY_NAMESPACE
 		FixedPoint<B, F> Regularity;
 
 	protected:
-		TreeCacheAllocPool<B, F, 2> Pool;
+		// Cache built in PreProcess(). Kept in the context so it's reused between calls.
+		struct State : NoiseNodeState
+		{
+			TreeCacheAllocPool<B, F, 2> Pool;
+		};
 	};
 }
 HWY_AFTER_NAMESPACE();
@@ -30,47 +30,219 @@ namespace SIMD::HWY_NAMESPACE
 
 		virtual ~WarpNode() = default;
 
-		virtual void PreProcess(const std::vector<NoiseSamplingBound<B, F>>& bounds) override {
-			std::vector<NoiseSamplingBound<B, F>> newBounds = bounds;
+		virtual void PreProcess(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds, NoiseExecutionContext& context
+		) const override {
+			// If the shift is unbounded, the coordinates can move anywhere. The base and shift are
+			// then preprocessed over the bounds known so far, and their caches fall back to
+			// sampling for the coordinates outside of them.
+			std::vector<NoiseSamplingBound<B, F>> baseBounds;
+			std::vector<NoiseSamplingBound<B, F>> shiftBounds;
+			GetWarpedBounds(bounds, baseBounds, shiftBounds);
 
-			// Each layer increases the range of the axis by strength. 
-			FixedPoint<B, F> strengthOffset = 1;
+			Base->PreProcess(baseBounds, context);
+			Shift->PreProcess(shiftBounds, context);
+		}
 
-			for (size_t i = 0; i < Layers; ++i) {
-				strengthOffset *= Strength;
+		NoiseRange<B, F> GetRange(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds
+		) const override {
+			if (bounds.size() < 2) {
+				return NoiseRange<B, F>::Unbounded();
 			}
 
-			for (size_t i = 0; i < newBounds.size(); ++i) {
-				newBounds[i].Start -= strengthOffset;
-				newBounds[i].End += strengthOffset;
+			std::vector<NoiseSamplingBound<B, F>> baseBounds;
+			std::vector<NoiseSamplingBound<B, F>> shiftBounds;
+
+			// Unbounded shifts can move the coordinates anywhere.
+			if (!GetWarpedBounds(bounds, baseBounds, shiftBounds)) {
+				return NoiseRange<B, F>::Unbounded();
 			}
 
-			Base->PreProcess(newBounds);
+			return Base->GetRange(baseBounds);
+		}
 
-			// Each axis also needs to have + 0.5, as warp implementation uses an offset. 
-			for (size_t i = 0; i < newBounds.size(); ++i) {
-				newBounds[i].End += 0.5;
+		NoiseAxes GetAxes(size_t dimensions) const override {
+			// The warped x and y depend on the shift, which is sampled at every axis. 
+			const NoiseAxes axes = Base->GetAxes(dimensions);
+
+			if (!HasAnyAxis(axes, NoiseAxes::XY)) {
+				return axes;
 			}
 
-			Shift->PreProcess(newBounds);
+			return axes | NoiseAxes::XY | Shift->GetAxes(dimensions);
 		}
 
-		vec operator()(vec x, vec y) override {
-			return Warp<B, F, NodeBaseSIMD<B, F>>(
-				x, y, *Base, *Shift, Layers, Strength
-			);
+		// Same as Warp(), but every layer samples the shift over the whole block at once. 
+		void Evaluate(const NoiseBlock<B, F>& block, T<B, F>* HWY_RESTRICT out) const override {
+			using fpc = FixedPointConstant<B, F>;
+			const D<B, F> d;
+			const bool is3D = block.Is3D();
+
+			// Rescales the values from [0, 1] to [-strength, strength]
+			auto RescaleRangeLambda = [&](vec value) {
+				return FPMul<B, F>(Strength, FPSub<B, F>(hn::ShiftLeft<1>(value), 1));
+			};
+
+			// Warped coordinates, offset coordinates, and the sampled shift of each offset
+			ScratchBuffer<B, F> x, y, offsetX, offsetY, offsetZ, shiftX, shiftY, shiftZ;
+			const NoiseBlock<B, F> warpedBlock = block.WithCoordinates(x, y, block.Z);
+			const NoiseBlock<B, F> offsetBlock = block.WithCoordinates(
+				offsetX, offsetY, is3D ? offsetZ.Get() : nullptr);
+
+			// Samples the shift at the warped coordinates + offset. 
+			// Note - 3D uses the offset y for z, to keep the same output as Warp(). 
+			auto SampleShiftLambda = [&](FixedPoint<B, F> offset, T<B, F>* HWY_RESTRICT shiftOut) {
+				ForEachVector<B, F>(block.Count, [&](int i) {
+					vec shiftedY = FPAdd<B, F>(hn::Load(d, y + i), offset);
+					hn::Store(FPAdd<B, F>(hn::Load(d, x + i), offset), d, offsetX + i);
+					hn::Store(shiftedY, d, offsetY + i);
+
+					if (is3D) {
+						hn::Store(shiftedY, d, offsetZ + i);
+					}
+				});
+
+				Shift->Evaluate(offsetBlock, shiftOut);
+			};
+
+			ForEachVector<B, F>(block.Count, [&](int i) {
+				hn::Store(hn::Load(d, block.X + i), d, x + i);
+				hn::Store(hn::Load(d, block.Y + i), d, y + i);
+			});
+
+			for (unsigned int l = 0; l < Layers; l++) {
+				// Constant offsets of 0.5 and 0.375
+				Shift->Evaluate(warpedBlock, shiftX);
+				SampleShiftLambda(fpc::One >> 1, shiftY);
+
+				if (is3D) {
+					SampleShiftLambda((fpc::One >> 2) | (fpc::One >> 3), shiftZ);
+				}
+
+				ForEachVector<B, F>(block.Count, [&](int i) {
+					vec warpedX = FPAdd<B, F>(
+						hn::Load(d, x + i), RescaleRangeLambda(hn::Load(d, shiftX + i)));
+					vec warpedY = FPAdd<B, F>(
+						hn::Load(d, y + i), RescaleRangeLambda(hn::Load(d, shiftY + i)));
+
+					if (is3D) {
+						warpedY = FPAdd<B, F>(warpedY, RescaleRangeLambda(hn::Load(d, shiftZ + i)));
+					}
+
+					hn::Store(warpedX, d, x + i);
+					hn::Store(warpedY, d, y + i);
+				});
+			}
+
+			Base->Evaluate(warpedBlock, out);
 		}
 
-		vec operator()(vec x, vec y, vec z) override {
-			return Warp<B, F, NodeBaseSIMD<B, F>>(
-				x, y, z, *Base, *Shift, Layers, Strength
-			);
+		int Compile(
+			NoiseProgramBuilder<B, F>& builder, 
+			const typename NoiseProgramBuilder<B, F>::Coordinates& coords
+		) const override {
+			using fpc = FixedPointConstant<B, F>;
+			typename NoiseProgramBuilder<B, F>::Coordinates warped = coords;
+
+			// Same offsets as Evaluate(), including 3D using the offset y for z.
+			auto OffsetLambda = [&](FixedPoint<B, F> offset) {
+				int x = builder.Emit(NoiseOp::AddConstant, { warped.X }, offset);
+				int y = builder.Emit(NoiseOp::AddConstant, { warped.Y }, offset);
+				return typename NoiseProgramBuilder<B, F>::Coordinates{ 
+					x, y, coords.Is3D() ? y : -1 
+				};
+			};
+
+			for (unsigned int l = 0; l < Layers; l++) {
+				int shiftX = Shift->Compile(builder, warped);
+				int shiftY = Shift->Compile(builder, OffsetLambda(fpc::One >> 1));
+				int shiftZ = coords.Is3D() ? 
+					Shift->Compile(builder, OffsetLambda((fpc::One >> 2) | (fpc::One >> 3))) : -1;
+
+				warped.X = builder.Emit(NoiseOp::WarpAccumulate, { warped.X, shiftX }, Strength);
+				warped.Y = builder.Emit(NoiseOp::WarpAccumulate, { warped.Y, shiftY }, Strength);
+
+				if (coords.Is3D()) {
+					warped.Y = builder.Emit(
+						NoiseOp::WarpAccumulate, { warped.Y, shiftZ }, Strength);
+				}
+			}
+
+			return Base->Compile(builder, warped);
 		}
 
 		std::shared_ptr<NodeBaseSIMD<B, F>> Base;
 		std::shared_ptr<NodeBaseSIMD<B, F>> Shift;
 		unsigned int Layers;
 		FixedPoint<B, F> Strength;
+
+	protected:
+		// Bounds of the coordinates the base and the shift are sampled at, for samples within the
+		// bounds. Returns false if the shift's range is unbounded, in which case the bounds only
+		// cover the layers before it. Bounds that aren't 2D or 3D are returned as they are.
+		bool GetWarpedBounds(
+			const std::vector<NoiseSamplingBound<B, F>>& bounds,
+			std::vector<NoiseSamplingBound<B, F>>& baseBounds,
+			std::vector<NoiseSamplingBound<B, F>>& shiftBounds
+		) const {
+			using fp = FixedPoint<B, F>;
+			using fpc = FixedPointConstant<B, F>;
+
+			baseBounds = bounds;
+			shiftBounds = bounds;
+
+			if (bounds.size() < 2) {
+				return true;
+			}
+
+			const bool is3D = bounds.size() >= 3;
+			const fp strength = (Strength < 0) ? -Strength : Strength;
+
+			// Max distance the coordinates have moved so far. Each layer moves x and y by at most
+			// |2 * shift - 1| * |strength|, and 3D moves y twice.
+			fp displacementX = 0;
+			fp displacementY = 0;
+			bool isBounded = true;
+
+			for (unsigned int l = 0; l < Layers; ++l) {
+				std::vector<NoiseSamplingBound<B, F>> layerBounds = bounds;
+				layerBounds[0].Start -= displacementX;
+				layerBounds[0].End += displacementX + (fpc::One >> 1);
+				layerBounds[1].Start -= displacementY;
+				layerBounds[1].End += displacementY + (fpc::One >> 1);
+
+				// The offset shifts of 3D are sampled with the offset y as z.
+				if (is3D) {
+					layerBounds[2].Start = std::min(layerBounds[2].Start, layerBounds[1].Start);
+					layerBounds[2].End = std::max(layerBounds[2].End, layerBounds[1].End);
+				}
+
+				// Layers only move further out, so the last layer's bounds contain the others.
+				shiftBounds = layerBounds;
+
+				NoiseRange<B, F> shift = Shift->GetRange(layerBounds);
+
+				if (shift.IsUnbounded()) {
+					isBounded = false;
+					break;
+				}
+
+				NoiseRange<B, F> rescaled{ (shift.Min << 1) - 1, (shift.Max << 1) - 1 };
+
+				// + 1 unit for rounding
+				fp displacement = rescaled.MaxMagnitude() * strength + fp::FromBase(1);
+				displacementX += displacement;
+				displacementY += is3D ? (displacement << 1) : displacement;
+			}
+
+			baseBounds[0].Start -= displacementX;
+			baseBounds[0].End += displacementX;
+			baseBounds[1].Start -= displacementY;
+			baseBounds[1].End += displacementY;
+
+			return isBounded;
+		}
 	};
 }
 HWY_AFTER_NAMESPACE();
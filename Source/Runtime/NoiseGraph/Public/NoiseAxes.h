@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Set of sampling axes that a value depends on.
+enum class NoiseAxes : uint8_t
+{
+	None = 0,
+	X = 1 << 0,
+	Y = 1 << 1,
+	Z = 1 << 2,
+	XY = X | Y,
+	XYZ = X | Y | Z,
+};
+
+inline constexpr NoiseAxes operator|(NoiseAxes lhs, NoiseAxes rhs) {
+	return NoiseAxes(uint8_t(lhs) | uint8_t(rhs));
+}
+
+inline constexpr NoiseAxes operator&(NoiseAxes lhs, NoiseAxes rhs) {
+	return NoiseAxes(uint8_t(lhs) & uint8_t(rhs));
+}
+
+inline constexpr NoiseAxes& operator|=(NoiseAxes& lhs, NoiseAxes rhs) {
+	return lhs = lhs | rhs;
+}
+
+// Returns true if axes contains any of the axes in other.
+inline constexpr bool HasAnyAxis(NoiseAxes axes, NoiseAxes other) {
+	return (axes & other) != NoiseAxes::None;
+}
+
+// Axis at index (0 = X, 1 = Y, 2 = Z).
+inline constexpr NoiseAxes NoiseAxisAt(size_t index) {
+	return NoiseAxes(uint8_t(1) << index);
+}
+
+// Every axis of a sampled region with the given number of dimensions.
+inline constexpr NoiseAxes NoiseAxesOf(size_t dimensions) {
+	return NoiseAxes((uint8_t(1) << dimensions) - 1);
+}
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Base class for anything a node creates in PreProcess() (caches, bounds, etc...).
+struct NoiseNodeState
+{
+	virtual ~NoiseNodeState() = default;
+};
+
+// Holds all of the mutable state of a single sampling call.
+//
+// Nodes are immutable after Build(). Anything a node needs to create per sample call is stored in
+// the context instead, keyed by the node that owns it. So a single graph can be sampled from many
+// threads at once without locks, as long as every concurrent call uses its own context.
+//
+// Contexts keep their states between calls, so nodes can reuse their allocations. States are keyed
+// by their type as well as their node, so a node allocated where a destroyed node used to be
+// (e.g. after the graph is built again) never gets a state of another type. Reset() contexts that
+// are kept across builds, since the destroyed nodes' states are never released otherwise.
+class NoiseExecutionContext
+{
+public:
+	NoiseExecutionContext() = default;
+	NoiseExecutionContext(const NoiseExecutionContext&) = delete;
+	NoiseExecutionContext& operator=(const NoiseExecutionContext&) = delete;
+
+	// Returns the node's state, and creates it if it does not exist yet.
+	// Only call this from PreProcess(), since it may modify the context.
+	template <typename TState>
+	TState& GetOrCreateState(const void* node) {
+		std::unique_ptr<NoiseNodeState>& state = States[Key::Of<TState>(node)];
+
+		if (!state) {
+			state = std::make_unique<TState>();
+		}
+
+		return static_cast<TState&>(*state);
+	}
+
+	// Returns the node's state. The state must have been created in PreProcess().
+	// Read-only, so it is safe to call from multiple threads during Process().
+	template <typename TState>
+	const TState& GetState(const void* node) const {
+		auto it = States.find(Key::Of<TState>(node));
+		assert(it != States.end());
+		return static_cast<const TState&>(*it->second);
+	}
+
+	// Returns the node's state, or nullptr if it was never created.
+	template <typename TState>
+	TState* FindState(const void* node) {
+		auto it = States.find(Key::Of<TState>(node));
+		return (it != States.end()) ? static_cast<TState*>(it->second.get()) : nullptr;
+	}
+
+	template <typename TState>
+	const TState* FindState(const void* node) const {
+		auto it = States.find(Key::Of<TState>(node));
+		return (it != States.end()) ? static_cast<const TState*>(it->second.get()) : nullptr;
+	}
+
+	// Number of samples the nodes are preprocessed for, or 0 if unknown. Set by the sampler
+	// before PreProcess(), so that nodes can skip caches that cost more than the samples save.
+	void SetSampleCount(int64_t count) {
+		SampleCount = count;
+	}
+
+	int64_t GetSampleCount() const {
+		return SampleCount;
+	}
+
+	// Releases all states, and the allocations held by them.
+	void Reset() {
+		States.clear();
+		SampleCount = 0;
+	}
+
+private:
+	struct Key
+	{
+		const void* Node;
+		std::type_index Type;
+
+		template <typename TState>
+		static Key Of(const void* node) {
+			return Key{ node, std::type_index(typeid(TState)) };
+		}
+
+		bool operator==(const Key& other) const {
+			return Node == other.Node && Type == other.Type;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const {
+			return std::hash<const void*>()(key.Node) ^ (key.Type.hash_code() * 31);
+		}
+	};
+
+	std::unordered_map<Key, std::unique_ptr<NoiseNodeState>, KeyHash> States;
+	int64_t SampleCount = 0;
+};
+
+// Thread-safe pool of contexts, for callers that do not want to own one.
+// Contexts are returned to the pool when the last handle to them is released.
+class NoiseExecutionContextPool : public std::enable_shared_from_this<NoiseExecutionContextPool>
+{
+public:
+	using Handle = std::shared_ptr<NoiseExecutionContext>;
+
+	Handle Acquire() {
+		NoiseExecutionContext* context = nullptr;
+		size_t generation = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			generation = Generation;
+
+			if (!Free.empty()) {
+				context = Free.back().release();
+				Free.pop_back();
+			}
+		}
+
+		if (!context) {
+			context = new NoiseExecutionContext();
+		}
+
+		// The handle keeps the pool alive, so contexts can be released after the pool's owner
+		// is gone.
+		std::shared_ptr<NoiseExecutionContextPool> pool = shared_from_this();
+		return Handle(context, [pool, generation](NoiseExecutionContext* released) {
+			pool->Release(released, generation);
+		});
+	}
+
+	// Releases the pooled contexts, and the states held by them. Contexts in use when it's called
+	// are released instead of being returned to the pool. Called when the graph's nodes change.
+	void Clear() {
+		std::vector<std::unique_ptr<NoiseExecutionContext>> released;
+
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			++Generation;
+			released.swap(Free);
+		}
+	}
+
+private:
+	void Release(NoiseExecutionContext* context, size_t generation) {
+		std::unique_ptr<NoiseExecutionContext> released(context);
+		std::lock_guard<std::mutex> lock(Mutex);
+
+		if (generation == Generation) {
+			Free.push_back(std::move(released));
+		}
+	}
+
+	std::mutex Mutex;
+	std::vector<std::unique_ptr<NoiseExecutionContext>> Free;
+	size_t Generation = 0;	// Incremented by Clear()
+};
@@ -5,11 +5,22 @@
 #include "NoiseGraphModule.h"
 #include "Numerics/FixedPoint.h"
 #include "Nodes/NodeBase.h"
+#include "NoiseExecutionContext.h"
+#include "NoiseRange.h"
+#include "NoisePoints.h"
+#include "NoiseTaskScheduler.h"
+#include "NoiseOutputView.h"
+#include "NoiseSampleStats.h"
+#include "NoiseGraphRecipe.h"
 #include "AlignedArray.h"
 #include "TypeTraits/VariantTypeTraits.h"
+#include <map>
+#include <mutex>
+#include <vector>
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "UObject/ObjectSaveContext.h"
 #include "NoiseGraph.generated.h"
 
 #define NOISEGRAPH_FP_PARAMS 32, 16
@@ -22,14 +33,21 @@ public:
 	using Sampler = std::shared_ptr<NodeBase<NOISEGRAPH_FP_PARAMS>>;
 
 	FNoiseKey() : ptr(nullptr) {}
-	FNoiseKey(Sampler sampler) : ptr(sampler) {}
+	FNoiseKey(Sampler sampler, NoiseNodeRecipePtr recipe = nullptr) : 
+		ptr(sampler), recipe(recipe) {}
 
 	const Sampler Get() const {
 		return ptr;
 	}
 
+	// How the node was created, to save the graph. nullptr for nodes created in native code.
+	const NoiseNodeRecipePtr GetRecipe() const {
+		return recipe;
+	}
+
 protected:
 	Sampler ptr;
+	NoiseNodeRecipePtr recipe;
 
 };
 
@@ -56,38 +74,459 @@ public:
 	// How this works:
 	// Build() logic is implemented in blueprints and will set the FNoiseKey Output. 
 	// Call it again if the blueprint changes to reflect the change. 
+	// Cooked graphs are loaded from CookedGraph instead, without running Build(). 
 	UFUNCTION(BlueprintImplementableEvent)
 	void Build();
 
 	UPROPERTY(BlueprintReadWrite)
 	FNoiseKey Output;
 
+	// Additional outputs of the graph (e.g. density, material, moisture...), sampled together
+	// with SampleOutputs(). Set by Build() along with Output. 
+	UPROPERTY(BlueprintReadWrite)
+	TMap<FName, FNoiseKey> NamedOutputs;
+
 	// *********************************************************************************************
 	// Allocations and Sampling API
 	template <typename T> requires exists_in_variant_v<T, Base::VarPtr, true>
-	static AlignedArray<T> Allocate(SamplingParameters params) {
+	static AlignedArray<T> Allocate(const SamplingParameters& params) {
 		return AlignedArray<T>(params.TotalSize());
 	}
 
+	// Sampling is reentrant. Every call uses its own execution context (taken from the graph's 
+	// pool if none is given), so the same graph can be sampled from several threads at once. 
+	// The graph is built and compiled once, under a lock, by whichever call samples it first.
+	// Build() runs blueprint code, so sample once (or call GetRecipe()) on the game thread before
+	// sampling from other threads.
+	//
+	// If stats isn't nullptr, the min / max / mean, histogram, threshold counts and checksum of
+	// the samples are added to it while sampling (e.g. to cull empty chunks, or detect desyncs).
+	using Stats = NoiseSampleStats<NOISEGRAPH_FP_PARAMS>;
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void Sample(const SamplingParameters& params, AlignedArray<T>& array, Stats* stats = nullptr) {
+		ContextHandle context = AcquireContext();
+		Sample(params, array, *context, stats);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void Sample(
+		const SamplingParameters& params, AlignedArray<T>& array, NoiseExecutionContext& context,
+		Stats* stats = nullptr
+	) {
+		Sampler sampler = GetSampler();
+		if (!sampler) return;
+
+		sampler->PreProcessGrid(params, context);
+		sampler->Process(params, array, context, stats);
+		sampler->PostProcess(context);
+	}
+
+	// Multi-core version of Sample(). The region is split into tiles that are sampled on the 
+	// worker threads. Output (and stats) are bit-identical to Sample(). 
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleParallel(
+		const SamplingParameters& params, AlignedArray<T>& array, Stats* stats = nullptr
+	) {
+		ContextHandle context = AcquireContext();
+		SampleParallel(params, array, *context, stats);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleParallel(
+		const SamplingParameters& params, AlignedArray<T>& array, NoiseExecutionContext& context,
+		Stats* stats = nullptr
+	) {
+		Sampler sampler = GetSampler();
+		if (!sampler) return;
+
+		sampler->PreProcessGrid(params, context);
+		sampler->ProcessParallel(params, array, context, stats);
+		sampler->PostProcess(context);
+	}
+
+	// *********************************************************************************************
+	// Output View API
+	//
+	// Same as Sample() and SampleParallel(), but writes straight into caller-owned memory (a 
+	// locked texture, a TArray, a field of a vertex struct, etc...) through a view of its layout,
+	// instead of into an AlignedArray that then has to be copied. 
+	template <typename T>
+	using OutputView = NoiseOutputView<T>;
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleInto(const SamplingParameters& params, const OutputView<T>& view) {
+		ContextHandle context = AcquireContext();
+		SampleInto(params, view, *context);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleInto(
+		const SamplingParameters& params, const OutputView<T>& view, 
+		NoiseExecutionContext& context
+	) {
+		Sampler sampler = GetSampler();
+		if (!sampler) return;
+
+		sampler->PreProcessGrid(params, context);
+		sampler->ProcessView(params, view, context);
+		sampler->PostProcess(context);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleIntoParallel(const SamplingParameters& params, const OutputView<T>& view) {
+		ContextHandle context = AcquireContext();
+		SampleIntoParallel(params, view, *context);
+	}
+
 	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
-	void Sample(SamplingParameters params, AlignedArray<T>& array) {
+	void SampleIntoParallel(
+		const SamplingParameters& params, const OutputView<T>& view, 
+		NoiseExecutionContext& context
+	) {
+		Sampler sampler = GetSampler();
+		if (!sampler) return;
 
-		// If not built yet, builds the sampler. 
+		sampler->PreProcessGrid(params, context);
+		sampler->ProcessViewParallel(params, view, context);
+		sampler->PostProcess(context);
+	}
+
+	// *********************************************************************************************
+	// Batch Sampling API
+	//
+	// Samples several regions at once (e.g. the ring of chunks streamed in around the player). 
+	// PreProcess() runs once over the union of their bounds, so caches that overlap between 
+	// regions (Tree, Cellular, etc...) are built once rather than per region. Small regions are
+	// packed together into the same blocks. Array i is resized to hold region i's samples.
+	// All regions must have the same number of dimensions. Keep batches close together, since 
+	// the caches cover the whole union. 
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleBatch(
+		const std::vector<SamplingParameters>& regions, std::vector<AlignedArray<T>>& arrays
+	) {
+		ContextHandle context = AcquireContext();
+		SampleBatch(regions, arrays, *context);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleBatch(
+		const std::vector<SamplingParameters>& regions, std::vector<AlignedArray<T>>& arrays,
+		NoiseExecutionContext& context
+	) {
+		arrays.resize(regions.size());
+
+		for (size_t i = 0; i < regions.size(); ++i) {
+			arrays[i].EnsureSize(regions[i].TotalSize());
+		}
+
+		Sampler sampler = GetSampler();
+		if (!sampler || regions.empty()) return;
+
+		int64_t sampleCount = 0;
+
+		for (const SamplingParameters& region : regions) {
+			sampleCount += region.TotalSize();
+		}
+
+		context.SetSampleCount(sampleCount);
+		sampler->PreProcess(GetNoiseBoundsUnion<NOISEGRAPH_FP_PARAMS>(regions), context);
+		sampler->ProcessBatch(regions, arrays, context);
+		sampler->PostProcess(context);
+	}
+
+	// *********************************************************************************************
+	// Multi-Output Sampling API
+	//
+	// Samples several named outputs over the same region in a single pass, array j holding the
+	// output names[j]. The outputs are compiled into one program, so the nodes they share (e.g. 
+	// a base terrain shape feeding both density and material) are evaluated once per sample 
+	// rather than once per output. Arrays are resized to hold the samples. 
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleOutputs(
+		const SamplingParameters& params, const std::vector<FName>& names, 
+		std::vector<AlignedArray<T>>& arrays
+	) {
+		ContextHandle context = AcquireContext();
+		SampleOutputs(params, names, arrays, *context);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleOutputs(
+		const SamplingParameters& params, const std::vector<FName>& names, 
+		std::vector<AlignedArray<T>>& arrays, NoiseExecutionContext& context
+	) {
+		arrays.resize(names.size());
+
+		for (AlignedArray<T>& array : arrays) {
+			array.EnsureSize(params.TotalSize());
+		}
+
+		Sampler sampler = GetOutputsSampler(names);
+		if (!sampler) return;
+
+		sampler->PreProcessGrid(params, context);
+		sampler->ProcessOutputs(params, arrays, context);
+		sampler->PostProcess(context);
+	}
+
+	// *********************************************************************************************
+	// Async Sampling API
+	//
+	// Samples on the shared worker pool, off the calling thread (e.g. for chunk streaming). Tasks
+	// with a higher priority run first, and take over the workers between the tiles of lower
+	// priority ones, so near chunks can go before far ones (e.g. the negated distance).
+	// The array must stay alive until the task is done. Cancelled tasks stop between tiles, and 
+	// leave the array partially written. 
+	using Task = NoiseTask;
+	using TaskHandle = NoiseTaskHandle;
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	TaskHandle SampleAsync(
+		const SamplingParameters& params, AlignedArray<T>& array, int priority = 0
+	) {
+		// Building isn't thread-safe, so the sampler is built on the calling thread.
+		Sampler sampler = GetSampler();
+		ContextHandle context = AcquireContext();
+
+		const int count = params.TotalSize();
+		const int tileCount = sampler ? (count + Base::TileSize - 1) / Base::TileSize : 0;
+		AlignedArray<T>* output = &array;
+
+		TaskHandle task = std::make_shared<Task>(
+			priority, tileCount,
+			[=]() {
+				if (sampler) sampler->PreProcessGrid(params, *context);
+			},
+			[=](int tile) {
+				const int begin = tile * Base::TileSize;
+				const int end = std::min(begin + Base::TileSize, count);
+				sampler->ProcessRange(params, *output, begin, end, *context);
+			},
+			[=](NoiseTaskStatus) {
+				if (sampler) sampler->PostProcess(*context);
+			}
+		);
+
+		NoiseTaskScheduler::Get().Schedule(task);
+		return task;
+	}
+
+	// *********************************************************************************************
+	// Point Sampling API
+	//
+	// Samples at arbitrary points rather than a grid, for gameplay queries (foliage placement, 
+	// ground checks, etc...). Queue a frame's queries into Points, and sample them in one pass. 
+	// Value i of the array is the value at point i. The array must hold at least Count() values.
+	// Caches are built over the bounding box of the points, so avoid batching far away points.
+	using Points = NoisePoints<NOISEGRAPH_FP_PARAMS>;
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleAt(const Points& points, AlignedArray<T>& array) {
+		ContextHandle context = AcquireContext();
+		SampleAt(points, array, *context);
+	}
+
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleAt(const Points& points, AlignedArray<T>& array, NoiseExecutionContext& context) {
+		SampleAt(points.GetX(), points.GetY(), points.GetZ(), points.Count(), array, context);
+	}
+
+	// Same as above, with the coordinates in raw fixed point SoA arrays. z is nullptr for 2D.
+	template <typename T>  requires exists_in_variant_v<T, Base::VarPtr, true>
+	void SampleAt(
+		const Fp::base_type* x, const Fp::base_type* y, const Fp::base_type* z, int count, 
+		AlignedArray<T>& array, NoiseExecutionContext& context) {
+		Sampler sampler = GetSampler();
+		if (!sampler || count <= 0) return;
+
+		context.SetSampleCount(count);
+		sampler->PreProcess(GetNoisePointBounds<NOISEGRAPH_FP_PARAMS>(x, y, z, count), context);
+		sampler->ProcessPoints(x, y, z, count, array, context);
+		sampler->PostProcess(context);
+	}
+
+	// *********************************************************************************************
+	// Range Analysis
+	//
+	// Conservative bounds of the graph's output over a region, without sampling it. Used to skip
+	// regions that are fully solid or fully empty, e.g. before meshing a chunk.
+	// Regions are Inside if every value is at or above the threshold (solid, for SurfaceNets).
+	using Range = NoiseRange<NOISEGRAPH_FP_PARAMS>;
+	using Brick = NoiseSamplingBrick<NOISEGRAPH_FP_PARAMS>;
+
+	Range GetRange(const SamplingParameters& params) {
+		Sampler sampler = GetSampler();
+		if (!sampler) return Range::Unbounded();
+
+		return sampler->GetRange(params.GetBounds());
+	}
+
+	NoiseRegionClass Classify(const SamplingParameters& params, Fp threshold = Fp(1) >> 1) {
+		return ClassifyNoiseRange<NOISEGRAPH_FP_PARAMS>(GetRange(params), threshold);
+	}
+
+	// Splits the region into bricks, so that only the Mixed bricks need to be sampled.
+	// Bricks are split until no axis is longer than minSize samples.
+	void Subdivide(
+		const SamplingParameters& params, int minSize, Fp threshold, std::vector<Brick>& bricks
+	) {
+		Sampler sampler = GetSampler();
+
+		if (!sampler) {
+			std::vector<int> offsets(params.GetDimensions(), 0);
+			bricks.push_back(Brick{ params, offsets, NoiseRegionClass::Mixed });
+			return;
+		}
+
+		SubdivideNoiseRegion<NOISEGRAPH_FP_PARAMS>(
+			params, std::vector<int>(params.GetDimensions(), 0), minSize, threshold,
+			[&](const std::vector<NoiseSamplingBound<NOISEGRAPH_FP_PARAMS>>& bounds) {
+				return sampler->GetRange(bounds);
+			},
+			bricks
+		);
+	}
+
+	// *********************************************************************************************
+	// Execution Contexts
+	// 
+	// Callers that sample often from the same thread (e.g. a chunk streaming worker) can hold on
+	// to a context, so that node caches are reused between calls. Held contexts keep the states of
+	// the nodes they sampled, so release or Reset() them when the graph is built again.
+	using ContextHandle = NoiseExecutionContextPool::Handle;
+
+	ContextHandle AcquireContext() {
+		return ContextPool->Acquire();
+	}
+
+	// *********************************************************************************************
+	// Cooked Graphs
+	//
+	// The built graph (node types, fixed point arguments and outputs) is saved into CookedGraph 
+	// when the asset is cooked. Cooked graphs are loaded straight into native nodes the first
+	// time they're sampled, so that Build() and the blueprint VM never run in a packaged game.
+	using Recipe = NoiseGraphRecipe;
+
+	UPROPERTY()
+	TArray<uint8> CookedGraph;
+
+	// Content hash of the cooked graph. See GetContentHash().
+	UPROPERTY(VisibleAnywhere)
+	uint64 CookedGraphHash = 0;
+
+	// Recipe of the graph's outputs (building the graph if needed). 
+	Recipe GetRecipe();
+
+	// Stable hash of the graph's nodes and arguments, the same on every platform and build. 
+	// E.g. for servers and clients to check that they generate the same world.
+	// Returns 0 if the graph can't be built or saved.
+	uint64 GetContentHash() {
+		return GetRecipe().Hash();
+	}
+
+	// Builds the graph, and saves it into CookedGraph. Returns false if the graph can't be built,
+	// or has nodes that weren't created through the Get[nodename]() functions.
+	bool Cook();
+
+	// Creates Output and NamedOutputs from CookedGraph. Returns false if it isn't valid. 
+	bool LoadCooked();
+
+	virtual void PreSave(FObjectPreSaveContext saveContext) override;
+
+	// *********************************************************************************************
+	// Samplers
+	//
+	// The compiled graph, for callers that run the sampling steps themselves. E.g. to sample on
+	// the render thread, resolve the sampler and a context from AcquireContext() on the game
+	// thread (since Build() runs blueprint code), then call PreProcessGrid(), ProcessView() or
+	// the like, and PostProcess() on them without touching the graph again.
+
+	// If not built yet, loads the cooked graph or builds it. Returns nullptr if neither worked.
+	// The output graph is compiled into a program the first time it's sampled, and again 
+	// whenever Output changes. Returns a copy, so the program outlives a concurrent rebuild.
+	Sampler GetSampler() {
+		std::lock_guard<std::mutex> lock(CompileMutex);
+		return GetSamplerLocked();
+	}
+
+protected:
+	// Same as GetSampler(), for a program with an output per name. Returns nullptr if one of the
+	// names isn't an output of the graph. Programs are compiled once per set of outputs.
+	Sampler GetOutputsSampler(const std::vector<FName>& names) {
+		if (names.empty()) return nullptr;
+
+		std::lock_guard<std::mutex> lock(CompileMutex);
+		if (!GetSamplerLocked()) return nullptr;
+
+		std::vector<Sampler> roots;
+		std::vector<const Base*> key;
+
+		for (const FName& name : names) {
+			const FNoiseKey* output = NamedOutputs.Find(name);
+
+			if (!output || !output->Get()) {
+				UE_LOG(LogNoiseGraph, Warning, 
+					TEXT("NoiseGraph has no output named %s."), *name.ToString());
+				return nullptr;
+			}
+
+			roots.push_back(output->Get());
+			key.push_back(output->Get().get());
+		}
+
+		Sampler& compiled = CompiledOutputs[key];
+
+		if (!compiled) {
+			compiled = Compile(roots);
+		}
+
+		return compiled;
+	}
+
+	// GetSampler(), with CompileMutex held.
+	Sampler GetSamplerLocked() {
 		if (!Output.Get()) {
-			Build();
+			if (CookedGraph.IsEmpty() || !LoadCooked()) {
+				Build();
+			}
 
 			if (!Output.Get()) {
 				UE_LOG(LogNoiseGraph, Warning, TEXT("Could not build NoiseGraph."));
-				return;
+				return nullptr;
 			}
 		}
 
-		Sampler sampler = Output.Get();
-		sampler->PreProcess(params.GetBounds());
-		sampler->Process(params, array);
-		sampler->PostProcess();
+		if (CompiledFrom != Output.Get().get()) {
+			Compiled = Compile({ Output.Get() });
+			CompiledFrom = Output.Get().get();
+			CompiledOutputs.clear();
+
+			// The pooled contexts hold the states of the previous nodes.
+			ContextPool->Clear();
+		}
+
+		return Compiled;
 	}
 
+	// Lowers the node graphs into a program node, with an output per root. Implemented in 
+	// NoiseGraph.cpp, since it dispatches to the SIMD target the nodes were built with. 
+	static Sampler Compile(const std::vector<Sampler>& roots);
+
+	Sampler Compiled;
+	const Base* CompiledFrom = nullptr;	// Compiled holds on to it, so it can't be reused
+
+	// Multi-output programs, by their roots. Cleared when the graph is built again.
+	std::map<std::vector<const Base*>, Sampler> CompiledOutputs;
+
+	// Guards building, compiling and the fields above, which are filled lazily by the first
+	// sampling calls, possibly from several threads at once.
+	std::mutex CompileMutex;
+
+	std::shared_ptr<NoiseExecutionContextPool> ContextPool = 
+		std::make_shared<NoiseExecutionContextPool>();
+
+public:
 	// *********************************************************************************************
 	// Nodes
 	UFUNCTION(BlueprintPure)
@@ -96,6 +535,11 @@ public:
 	UFUNCTION(BlueprintPure)
 	static UPARAM(DisplayName = "Key") FNoiseKey GetPerlin(float seed = 0);
 
+	// Similar to Perlin, but with 3 corners per sample in 2D and 4 in 3D (rather than 4 and 8),
+	// so it's about half the cost in 3D.
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Key") FNoiseKey GetSimplex(float seed = 0);
+
 	UFUNCTION(BlueprintPure)
 	static UPARAM(DisplayName = "Key") FNoiseKey GetCellular(
 		int feature = 0, float seed = 0, int maxPointsPerGrid = 1
@@ -121,11 +565,20 @@ public:
 		FNoiseKey baseKey, float upperBound = 100, float lowerBound = 0
 	);
 
+	// Samples the base every stride units, and interpolates in between. For low frequency noise.
+	// The stride is rounded to the nearest power of two (e.g. 8, 16, 0.5).
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Key") FNoiseKey GetResample(FNoiseKey baseKey, float stride = 8);
+
 	// Modifiers
 
 	UFUNCTION(BlueprintPure)
 	static UPARAM(DisplayName = "Key") FNoiseKey GetInvert(FNoiseKey baseKey);
 
+	// Samples the base in 2D when sampling in 3D. Evaluated once per column of a 3D grid.
+	UFUNCTION(BlueprintPure)
+	static UPARAM(DisplayName = "Key") FNoiseKey GetFlatten(FNoiseKey baseKey);
+
 
 	// *********************************************************************************************
 	// Events
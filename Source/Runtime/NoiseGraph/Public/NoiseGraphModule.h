@@ -3,6 +3,8 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "NoiseTaskScheduler.h"
+#include <memory>
 
 NOISEGRAPH_API DECLARE_LOG_CATEGORY_EXTERN(LogNoiseGraph, Log, All);
 
@@ -11,4 +13,8 @@ class FNoiseGraphModule : public IModuleInterface
 public:
     virtual void StartupModule() override;
     virtual void ShutdownModule() override;
+
+private:
+    // Shared scheduler returned by NoiseTaskScheduler::Get()
+    std::unique_ptr<NoiseTaskScheduler> TaskScheduler;
 };
\ No newline at end of file
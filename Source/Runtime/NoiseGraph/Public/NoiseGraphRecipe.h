@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Node types that can be saved into a graph blob.
+// The values are stored in blobs, so new types must be added at the end (before Count).
+enum class NoiseNodeType : uint8_t
+{
+	Random,
+	Perlin,
+	Cellular,
+	Fractal,
+	Warp,
+	Tree,
+	Heightmap,
+	Resample,
+	Invert,
+	Flatten,
+	Simplex,
+	Count
+};
+
+struct NoiseNodeRecipe;
+using NoiseNodeRecipePtr = std::shared_ptr<const NoiseNodeRecipe>;
+
+// Raw bits of a fixed point argument, so that it loads back exactly, on every platform.
+struct NoiseFixedArgument
+{
+	int64_t Raw;
+};
+
+// How a node was created: its type, and the arguments given to UNoiseGraph::Get[nodename](),
+// with floats in fixed point and keys as the recipes of their nodes.
+struct NoiseNodeRecipe
+{
+	using Argument = std::variant<int32_t, NoiseFixedArgument, NoiseNodeRecipePtr>;
+
+	NoiseNodeType Type;
+	std::vector<Argument> Arguments;
+};
+
+// Recipes of a graph's outputs, which is all that's needed to create its nodes again without
+// running Build(). Nodes shared between outputs are stored once.
+struct NOISEGRAPH_API NoiseGraphRecipe
+{
+	NoiseNodeRecipePtr Output;
+	std::vector<std::pair<std::string, NoiseNodeRecipePtr>> NamedOutputs;	// Sorted by name
+
+	// Fixed point format (FixedPoint<BitsSize, FractionSize>) of the fixed arguments' raw bits.
+	// Written into blobs, since the same bits are a different number in another format.
+	uint8_t BitsSize = 0;
+	uint8_t FractionSize = 0;
+
+	// Writes the recipes into a compact binary blob. Nodes are written children first, with
+	// their arguments as varints, and nodes with the same type and arguments are written once.
+	// Returns false if there is no Output, or a node has no recipe (e.g. a key that wasn't
+	// created through a Get[nodename]() function).
+	bool Serialize(std::vector<uint8_t>& blob) const;
+
+	// Reads a blob written by Serialize(). Returns false if the blob is invalid, or if its fixed
+	// arguments aren't in the format FixedPoint<bitsSize, fractionSize>.
+	static bool Deserialize(
+		const uint8_t* data, size_t size, uint8_t bitsSize, uint8_t fractionSize,
+		NoiseGraphRecipe& recipe);
+
+	// Stable content hash (FNV-1a) of a blob. Blobs don't depend on the platform, on the order
+	// the graph was built in, or on which of its identical nodes are shared, so graphs with the
+	// same nodes have the same hash everywhere (e.g. for servers and clients to check they
+	// generate the same world).
+	static uint64_t Hash(const uint8_t* data, size_t size);
+
+	// Hash of the serialized recipes, 0 if they can't be serialized.
+	uint64_t Hash() const;
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "NoiseSamplingParameters.h"
+#include "StoreMode.h"
+
+// Caller-owned memory that samples are written to, in place of an AlignedArray. 
+// Lets a sample call write straight into a locked texture, a TArray, or a field of an 
+// interleaved struct (e.g. a vertex's density), without a dense buffer to copy from. 
+// 
+// All strides are in elements of T. Sample (x, y, z) of the sampled grid is written to 
+// Data[ChannelOffset + x * ElementStride + y * RowPitch + z * SlicePitch], repeated over 
+// Channels consecutive elements (e.g. 3 for the RGB of a grayscale texel). 
+// If HasPad, the other elements of each sample's ElementStride are set to Pad (e.g. an opaque 
+// alpha), so that write-only memory is fully written. 
+// Mode picks how samples are rounded and clamped into integer types. 
+template <typename T>
+struct NoiseOutputView
+{
+	T* Data = nullptr;
+	int ElementStride = 1;
+	int RowPitch = 0;
+	int SlicePitch = 0;
+	int ChannelOffset = 0;
+	int Channels = 1;
+	bool HasPad = false;
+	T Pad = T();
+	SIMD::StoreMode Mode = SIMD::StoreMode::Saturate;
+
+	// Same layout as an AlignedArray sampled with params. 
+	template <size_t B, size_t F>
+	static NoiseOutputView Dense(T* data, const NoiseSamplingParameters<B, F>& params) {
+		NoiseOutputView view;
+		view.Data = data;
+		view.RowPitch = params.Size(0);
+		view.SlicePitch = view.RowPitch * (params.GetDimensions() > 1 ? params.Size(1) : 1);
+		return view;
+	}
+
+	// Interleaved rows of texels, e.g. a locked texture. rowPitch is in elements, not bytes. 
+	static NoiseOutputView Texels(T* data, int channelCount, int rowPitch) {
+		NoiseOutputView view;
+		view.Data = data;
+		view.ElementStride = channelCount;
+		view.RowPitch = rowPitch;
+		return view;
+	}
+
+	T* At(int x, int y, int z) const {
+		return Data + ChannelOffset + x * ElementStride + y * RowPitch + z * SlicePitch;
+	}
+
+	// True if the samples of a row are contiguous, so rows can be copied as is. 
+	bool IsRowContiguous() const {
+		return ElementStride == 1 && Channels == 1 && !HasPad;
+	}
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Numerics/FixedPoint.h"
+#include "NoiseSamplingParameters.h"
+#include <algorithm>
+#include <vector>
+
+// Returns the bounds of count points, for PreProcess(). z is nullptr for 2D points.
+template <size_t B, size_t F>
+inline std::vector<NoiseSamplingBound<B, F>> GetNoisePointBounds(
+	const typename FixedPoint<B, F>::base_type* x, const typename FixedPoint<B, F>::base_type* y,
+	const typename FixedPoint<B, F>::base_type* z, int count
+) {
+	using fp = FixedPoint<B, F>;
+	const typename fp::base_type* axes[3] = { x, y, z };
+	std::vector<NoiseSamplingBound<B, F>> bounds;
+
+	for (const typename fp::base_type* axis : axes) {
+		if (!axis || count <= 0) break;
+
+		auto minMax = std::minmax_element(axis, axis + count);
+		bounds.push_back(
+			NoiseSamplingBound<B, F>{ fp::FromBase(*minMax.first), fp::FromBase(*minMax.second) });
+	}
+
+	return bounds;
+}
+
+// Arbitrary points to sample at, in SoA layout. 
+// Gameplay code can queue its queries for a frame (foliage placement, ground checks, etc...), 
+// then sample all of them in a single pass with UNoiseGraph::SampleAt().
+template <size_t B, size_t F>
+class NoisePoints
+{
+	using fp = FixedPoint<B, F>;
+	using base_type = typename fp::base_type;
+
+public:
+	NoisePoints(size_t dimensions = 3) : Dimensions(dimensions) {}
+
+	// Queues a point, and returns its index in the sampled values. z is ignored by 2D points.
+	int Add(fp x, fp y, fp z) {
+		X.push_back(x.ToRaw());
+		Y.push_back(y.ToRaw());
+		if (Dimensions == 3) Z.push_back(z.ToRaw());
+		return Count() - 1;
+	}
+
+	// Same as above, at z = 0 for 3D points. Keeps Z as long as X and Y either way.
+	int Add(fp x, fp y) {
+		return Add(x, y, fp(0));
+	}
+
+	void Reserve(int count) {
+		X.reserve(count);
+		Y.reserve(count);
+		if (Dimensions == 3) Z.reserve(count);
+	}
+
+	void Clear() {
+		X.clear();
+		Y.clear();
+		Z.clear();
+	}
+
+	// Read-only accessors. GetZ() is nullptr for 2D points.
+	int Count() const {
+		return int(X.size());
+	}
+
+	size_t GetDimensions() const {
+		return Dimensions;
+	}
+
+	const base_type* GetX() const {
+		return X.data();
+	}
+
+	const base_type* GetY() const {
+		return Y.data();
+	}
+
+	const base_type* GetZ() const {
+		return (Dimensions == 3) ? Z.data() : nullptr;
+	}
+
+protected:
+	size_t Dimensions;
+	std::vector<base_type> X;
+	std::vector<base_type> Y;
+	std::vector<base_type> Z;
+};
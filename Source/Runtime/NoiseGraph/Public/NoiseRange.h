@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Numerics/FixedPoint.h"
+#include "Numerics/FixedPointConstants.h"
+#include "NoiseSamplingParameters.h"
+#include <algorithm>
+#include <vector>
+
+// Conservative [Min, Max] range of the values a node outputs within some bounds.
+// Every value the node can output is within the range, but the range may be wider than the
+// actual values.
+template <size_t B, size_t F>
+struct NoiseRange
+{
+	using fp = FixedPoint<B, F>;
+
+	fp Min;
+	fp Max;
+
+	// Range between two values, in any order.
+	static constexpr NoiseRange Of(fp a, fp b) {
+		return (a < b) ? NoiseRange{ a, b } : NoiseRange{ b, a };
+	}
+
+	// Range of values with no known bounds.
+	static constexpr NoiseRange Unbounded() {
+		return NoiseRange{ FixedPointConstant<B, F>::Min, FixedPointConstant<B, F>::Max };
+	}
+
+	// Whether an end of the range is unknown. Arithmetic on Unbounded() overflows, so nodes that
+	// derive their range from another node's return Unbounded() when it is.
+	constexpr bool IsUnbounded() const {
+		return Min == FixedPointConstant<B, F>::Min || Max == FixedPointConstant<B, F>::Max;
+	}
+
+	// Range of noise values, [0, 1].
+	static constexpr NoiseRange Unit() {
+		return NoiseRange{ fp(0), FixedPointConstant<B, F>::One };
+	}
+
+	NoiseRange Union(NoiseRange other) const {
+		return NoiseRange{ std::min(Min, other.Min), std::max(Max, other.Max) };
+	}
+
+	// Widens the range by some amount on each side. Used to cover for fixed point rounding.
+	NoiseRange Widen(fp amount) const {
+		return NoiseRange{ Min - amount, Max + amount };
+	}
+
+	// Largest absolute value in the range.
+	fp MaxMagnitude() const {
+		return std::max(Min < 0 ? -Min : Min, Max < 0 ? -Max : Max);
+	}
+
+	NoiseRange operator+(NoiseRange other) const {
+		return NoiseRange{ Min + other.Min, Max + other.Max };
+	}
+
+	NoiseRange operator*(fp scale) const {
+		return Of(Min * scale, Max * scale);
+	}
+};
+
+// Range of a fractal's output (see Fractal()), from the range of its base at each octave.
+// getOctaveRange(frequency) returns the range of the base over the bounds scaled by the octave's
+// frequency. Shared by FractalNode and StaticFractal.
+template <size_t B, size_t F, typename OctaveRangeFunc>
+inline NoiseRange<B, F> GetFractalNoiseRange(
+	unsigned int octaves, FixedPoint<B, F> persistance, FixedPoint<B, F> lacunarity,
+	OctaveRangeFunc&& getOctaveRange
+) {
+	using fp = FixedPoint<B, F>;
+	using fpc = FixedPointConstant<B, F>;
+
+	NoiseRange<B, F> value{ fp(0), fp(0) };
+	fp maxValue = 0;
+	fp amplitude = fpc::One;
+	fp frequency = fpc::One;
+
+	for (unsigned int o = 0; o < octaves; ++o) {
+		// (2 * sample - 1) * amplitude
+		NoiseRange<B, F> sample = getOctaveRange(frequency);
+		if (sample.IsUnbounded()) return sample;
+
+		NoiseRange<B, F> signedSample{ (sample.Min << 1) - 1, (sample.Max << 1) - 1 };
+		value = value + signedSample * amplitude;
+
+		maxValue += amplitude;
+
+		amplitude *= persistance;
+		frequency *= lacunarity;
+	}
+
+	// Each octave rounds down at most twice.
+	value = value.Widen(fp::FromBase(2 * octaves + 2));
+
+	if (maxValue == 0) return value;
+
+	fp scale = maxValue << 1;
+	return NoiseRange<B, F>::Of(value.Min / scale, value.Max / scale)
+		.Widen(fp::FromBase(2)) + NoiseRange<B, F>{ fp(1) >> 1, fp(1) >> 1 };
+}
+
+// Where a region sits relative to the isosurface at some threshold.
+enum class NoiseRegionClass : uint8_t
+{
+	Outside,	// Every value is below the threshold.
+	Inside,		// Every value is at or above the threshold.
+	Mixed,		// The region may contain the isosurface.
+};
+
+template <size_t B, size_t F>
+inline NoiseRegionClass ClassifyNoiseRange(NoiseRange<B, F> range, FixedPoint<B, F> threshold) {
+	if (range.Max < threshold) {
+		return NoiseRegionClass::Outside;
+	}
+	else if (range.Min >= threshold) {
+		return NoiseRegionClass::Inside;
+	}
+	else {
+		return NoiseRegionClass::Mixed;
+	}
+}
+
+// A sub-region of a sampled region, produced by SubdivideNoiseRegion().
+template <size_t B, size_t F>
+struct NoiseSamplingBrick
+{
+	NoiseSamplingParameters<B, F> Params;	// Parameters to sample the brick on its own
+	std::vector<int> Offsets;				// Sample index of the brick's start, on each axis
+	NoiseRegionClass Class;
+};
+
+// Recursively splits a region in half on its longest axis, until each brick is either fully 
+// inside / outside the isosurface, or no axis is longer than minSize samples. 
+// getRange(bounds) returns the NoiseRange of the noise within the bounds. 
+template <size_t B, size_t F, typename RangeFunc>
+inline void SubdivideNoiseRegion(
+	const NoiseSamplingParameters<B, F>& params, const std::vector<int>& offsets, int minSize, 
+	FixedPoint<B, F> threshold, RangeFunc&& getRange, std::vector<NoiseSamplingBrick<B, F>>& bricks
+) {
+	const NoiseRegionClass regionClass = 
+		ClassifyNoiseRange<B, F>(getRange(params.GetBounds()), threshold);
+
+	// Longest axis
+	size_t split = 0;
+	for (size_t i = 1; i < size_t(params.GetDimensions()); ++i) {
+		if (params.Size(i) > params.Size(split)) split = i;
+	}
+
+	if (regionClass != NoiseRegionClass::Mixed || params.GetDimensions() == 0 || 
+		params.Size(split) <= minSize) {
+		bricks.push_back(NoiseSamplingBrick<B, F>{ params, offsets, regionClass });
+		return;
+	}
+
+	const int lowerSize = params.Size(split) / 2;
+	NoiseSamplingParameters<B, F> lower(params.Spacing);
+	NoiseSamplingParameters<B, F> upper(params.Spacing);
+	std::vector<int> upperOffsets = offsets;
+	upperOffsets[split] += lowerSize;
+
+	for (size_t i = 0; i < size_t(params.GetDimensions()); ++i) {
+		if (i == split) {
+			lower.Add(params.Start(i), lowerSize);
+			upper.Add(
+				params.Start(i) + params.Spacing * lowerSize, params.Size(i) - lowerSize);
+		}
+		else {
+			lower.Add(params.Start(i), params.Size(i));
+			upper.Add(params.Start(i), params.Size(i));
+		}
+	}
+
+	SubdivideNoiseRegion<B, F>(lower, offsets, minSize, threshold, getRange, bricks);
+	SubdivideNoiseRegion<B, F>(upper, upperOffsets, minSize, threshold, getRange, bricks);
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Numerics/FixedPoint.h"
+#include "NoiseRange.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// Statistics of sampled values, computed while sampling (see NodeBase::Process()), so that 
+// callers don't need a second pass over the output. Used to cull empty chunks, and to detect
+// desyncs between machines. 
+//
+// Samples are accumulated, so the same stats can cover several calls. The values are those of the
+// samples before conversion to the output type, so they don't depend on it. 
+template <size_t B, size_t F>
+struct NoiseSampleStats
+{
+	using fp = FixedPoint<B, F>;
+	using base_type = typename fp::base_type;
+
+	// The histogram splits [0, 1) into HistogramSize buckets. Values outside of it are counted in 
+	// the first or last bucket. 
+	static constexpr int HistogramSize = 256;
+
+	explicit NoiseSampleStats(fp threshold = fp(1) >> 1) : Threshold(threshold) {}
+
+	// Samples at or above the threshold are counted in AboveCount (e.g. solid, for SurfaceNets).
+	fp Threshold;
+
+	int Count = 0;
+	int AboveCount = 0;
+	fp Min = fp::FromBase(std::numeric_limits<base_type>::max());
+	fp Max = fp::FromBase(std::numeric_limits<base_type>::lowest());
+	int64_t Sum = 0;	// Raw fixed point
+	std::array<uint32_t, HistogramSize> Histogram{};
+
+	// Sum of a hash of every sample's flattened index and value. Only depends on the samples, 
+	// not on the order they are processed in, so tiles and SIMD targets give the same checksum.
+	uint32_t Checksum = 0;
+
+	fp Mean() const {
+		return Count ? fp::FromBase(static_cast<base_type>(Sum / Count)) : fp(0);
+	}
+
+	NoiseRange<B, F> GetRange() const {
+		return NoiseRange<B, F>{ Min, Max };
+	}
+
+	// Same as ClassifyNoiseRange(), but exact. Only valid if Count > 0. 
+	NoiseRegionClass Classify() const {
+		if (AboveCount == 0) return NoiseRegionClass::Outside;
+		if (AboveCount == Count) return NoiseRegionClass::Inside;
+		return NoiseRegionClass::Mixed;
+	}
+
+	// Adds the samples of other (e.g. of another tile), which must have the same threshold. 
+	void Merge(const NoiseSampleStats& other) {
+		Count += other.Count;
+		AboveCount += other.AboveCount;
+		Min = std::min(Min, other.Min);
+		Max = std::max(Max, other.Max);
+		Sum += other.Sum;
+		Checksum += other.Checksum;
+
+		for (int i = 0; i < HistogramSize; ++i) {
+			Histogram[i] += other.Histogram[i];
+		}
+	}
+
+	// Empties the stats, and keeps the threshold. 
+	void Reset() {
+		*this = NoiseSampleStats(Threshold);
+	}
+};
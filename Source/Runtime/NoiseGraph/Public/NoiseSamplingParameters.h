@@ -4,6 +4,8 @@
 
 #include "Numerics/FixedPoint.h"
 #include "Numerics/FixedPointConstants.h"
+#include <cassert>
+#include <vector>
 
 template <size_t B, size_t F>
 struct NoiseSamplingBound
@@ -15,10 +17,15 @@ struct NoiseSamplingBound
 template <size_t B, size_t F>
 struct NoiseSamplingParameters
 {
+	// The parameters are copied and read for every block, so they are stored inline rather than 
+	// in vectors. That keeps them trivially copyable, and never allocates. 
+	static constexpr size_t MaxDimensions = 4;
+
 	FixedPoint<B, F> Spacing = FixedPointConstant<B, F>::One;
 protected:
-	std::vector<int> Sizes;
-	std::vector<NoiseSamplingBound<B, F>> Bounds;
+	int Sizes[MaxDimensions] = {};
+	NoiseSamplingBound<B, F> Bounds[MaxDimensions] = {};
+	size_t Dimensions = 0;
 
 public:
 
@@ -26,21 +33,24 @@ public:
 	NoiseSamplingParameters(FixedPoint<B, F> spacing) : Spacing(spacing) {}
 
 	void Add(FixedPoint<B, F> start, int size) {
-		Sizes.push_back(size);
+		assert(Dimensions < MaxDimensions);
+		Sizes[Dimensions] = size;
 
 		NoiseSamplingBound<B, F> bound;
 		bound.Start = start;
 		bound.End = start + (Spacing * size);
-		Bounds.push_back(bound);
+		Bounds[Dimensions] = bound;
+
+		++Dimensions;
 	}
 
-	// Read-only vector accessors
-	inline const std::vector<NoiseSamplingBound<B, F>>& GetBounds() const {
-		return Bounds;
+	// Vector copies, for PreProcess() and range analysis. Not meant for the sampling loop. 
+	inline std::vector<NoiseSamplingBound<B, F>> GetBounds() const {
+		return std::vector<NoiseSamplingBound<B, F>>(Bounds, Bounds + Dimensions);
 	}
 
-	inline const std::vector<int>& GetSizes() const {
-		return Sizes;
+	inline std::vector<int> GetSizes() const {
+		return std::vector<int>(Sizes, Sizes + Dimensions);
 	}
 
 	inline const int Size(size_t index) const {
@@ -58,15 +68,13 @@ public:
 
 
 	const int TotalSize() const {
-		size_t dimensions = Sizes.size();
-
-		if (dimensions == 0) {
+		if (Dimensions == 0) {
 			return 0;
 		}
 
 		size_t total = 1;
 
-		for (size_t i = 0; i < dimensions; ++i) {
+		for (size_t i = 0; i < Dimensions; ++i) {
 			total *= Sizes[i];
 		}
 
@@ -74,7 +82,29 @@ public:
 	}
 
 	const int GetDimensions() const {
-		return Sizes.size();
+		return Dimensions;
+	}
+
+};
+
+// Smallest bounds that contain the bounds of every region. Used to run PreProcess() once for
+// several regions. Regions must have the same number of dimensions. 
+template <size_t B, size_t F>
+std::vector<NoiseSamplingBound<B, F>> GetNoiseBoundsUnion(
+	const std::vector<NoiseSamplingParameters<B, F>>& regions
+) {
+	if (regions.empty()) return {};
+
+	std::vector<NoiseSamplingBound<B, F>> bounds = regions[0].GetBounds();
+
+	for (const NoiseSamplingParameters<B, F>& region : regions) {
+		assert(size_t(region.GetDimensions()) == bounds.size());
+
+		for (size_t i = 0; i < bounds.size(); ++i) {
+			if (region.Start(i) < bounds[i].Start) bounds[i].Start = region.Start(i);
+			if (region.End(i) > bounds[i].End) bounds[i].End = region.End(i);
+		}
 	}
 
-};
\ No newline at end of file
+	return bounds;
+}
\ No newline at end of file
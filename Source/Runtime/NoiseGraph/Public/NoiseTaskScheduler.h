@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class NoiseTaskScheduler;
+
+enum class NoiseTaskStatus : uint8_t
+{
+	Queued,
+	Running,
+	Completed,
+	Cancelled
+};
+
+// Asynchronous work split into tiles, run by a NoiseTaskScheduler.
+//
+// Prepare runs first, on a single worker. The tiles then run on any number of workers, in any
+// order. Finish runs once, after the last tile, or once a cancelled task's running tiles are done.
+// Cancellation is checked between tiles, so a cancelled task stops within a tile of work.
+class NOISEGRAPH_API NoiseTask
+{
+public:
+	using Callback = std::function<void(NoiseTaskStatus)>;
+
+	NoiseTask(
+		int priority, int tileCount,
+		std::function<void()> prepare,
+		std::function<void(int)> processTile,
+		std::function<void(NoiseTaskStatus)> finish
+	);
+
+	NoiseTask(const NoiseTask&) = delete;
+	NoiseTask& operator=(const NoiseTask&) = delete;
+
+	int GetPriority() const {
+		return Priority;
+	}
+
+	NoiseTaskStatus GetStatus() const {
+		return Status;
+	}
+
+	bool IsDone() const {
+		NoiseTaskStatus status = Status;
+		return status == NoiseTaskStatus::Completed || status == NoiseTaskStatus::Cancelled;
+	}
+
+	bool IsCancelled() const {
+		return Cancelled;
+	}
+
+	// Stops the task before its next tile. Tiles that are already running still finish.
+	void Cancel();
+
+	// Blocks until the task is completed or cancelled.
+	void Wait();
+
+	// Calls callback with the final status once the task is done, from the thread that finished
+	// it (usually a worker). Called right away if the task is already done.
+	void OnDone(Callback callback);
+
+private:
+	friend class NoiseTaskScheduler;
+
+	// Drops a reference, and finishes the task when it was the last one.
+	void Release();
+
+	const int Priority;
+	const int TileCount;
+
+	std::function<void()> Prepare;
+	std::function<void(int)> ProcessTile;
+	std::function<void(NoiseTaskStatus)> Finish;
+
+	NoiseTaskScheduler* Scheduler = nullptr;
+
+	// Only used by the worker that took the task's queue entry.
+	bool Prepared = false;
+	int NextTile = 0;
+
+	std::atomic<bool> Cancelled = false;
+	std::atomic<int> CompletedTiles = 0;
+	std::atomic<int> References = 1;	// The queue entry, and every running tile
+	std::atomic<NoiseTaskStatus> Status = NoiseTaskStatus::Queued;
+
+	std::mutex Mutex;
+	std::condition_variable DoneCondition;
+	std::vector<Callback> Callbacks;
+};
+
+using NoiseTaskHandle = std::shared_ptr<NoiseTask>;
+
+// Pool of worker threads that run NoiseTasks by priority.
+//
+// Tasks with a higher priority run first. A task goes back into the queue every time a worker
+// takes one of its tiles, so higher priority tasks take over the workers between tiles rather
+// than waiting for whole tasks. Tasks with the same priority run in the order they were scheduled.
+class NOISEGRAPH_API NoiseTaskScheduler
+{
+public:
+	explicit NoiseTaskScheduler(int workerCount);
+	~NoiseTaskScheduler();
+
+	NoiseTaskScheduler(const NoiseTaskScheduler&) = delete;
+	NoiseTaskScheduler& operator=(const NoiseTaskScheduler&) = delete;
+
+	void Schedule(NoiseTaskHandle task);
+
+	// Shared scheduler, with a worker per core (minus one for the game thread). It is owned by
+	// FNoiseGraphModule, and only exists while the module is loaded. The module stops it in
+	// ShutdownModule(), rather than a static destructor joining the workers while the module is
+	// being unloaded (under the loader lock on Windows, which deadlocks).
+	static NoiseTaskScheduler& Get();
+
+private:
+	friend class NoiseTask;
+	friend class FNoiseGraphModule;
+
+	// Set by FNoiseGraphModule while the module is loaded.
+	static std::atomic<NoiseTaskScheduler*> Shared;
+
+	struct Entry
+	{
+		int Priority;
+		uint64_t Sequence;
+		NoiseTaskHandle Task;
+
+		// Heap order, so the highest priority (then the lowest sequence) is at the front.
+		bool operator<(const Entry& other) const {
+			if (Priority != other.Priority) return Priority < other.Priority;
+			return Sequence > other.Sequence;
+		}
+	};
+
+	// Worker loop
+	void Run();
+
+	// Runs the next step (Prepare or a tile) of the entry's task.
+	void RunStep(Entry entry);
+
+	// Queues the entry, unless its task was cancelled. Returns false if it wasn't queued.
+	bool Push(Entry entry);
+
+	// Drops the entries of cancelled tasks, so they finish without waiting for their turn.
+	void Purge();
+
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::vector<Entry> Queue;	// Heap
+	uint64_t NextSequence = 0;
+	bool Stopping = false;
+
+	std::vector<std::thread> Workers;
+};
@@ -0,0 +1,527 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_PROGRAM_INTERPRETER_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_PROGRAM_INTERPRETER_SIMD_H_
+#undef NOISEGRAPH_PROGRAM_INTERPRETER_SIMD_H_
+#else
+#define NOISEGRAPH_PROGRAM_INTERPRETER_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "Numerics/FixedPointConstants.h"
+#include "Program/NoiseProgram.h"
+#include "Nodes/NoiseBlock.h"
+#include "Nodes/NodeBaseSIMD.h"
+#include "Nodes/GridCoordinates.h"
+#include "Nodes/CellularNode.h"
+#include "Functions/Random.h"
+#include "Functions/Perlin.h"
+#include "Functions/Simplex.h"
+#include "Functions/Cellular.h"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// *********************************************************************************************
+	// Loop helpers. out[i] = func(inputs[i]...) for every vector of the block.
+	// Inputs and out may be the same register, since every vector is loaded before it's stored.
+	template <size_t B, size_t F, typename Func>
+	HWY_INLINE void NoiseProgramMap(int count, T<B, F>* out, const T<B, F>* a, Func&& func) {
+		const D<B, F> d;
+		ForEachVector<B, F>(count, [&](int i) {
+			hn::Store(func(hn::Load(d, a + i)), d, out + i);
+		});
+	}
+
+	template <size_t B, size_t F, typename Func>
+	HWY_INLINE void NoiseProgramMap(
+		int count, T<B, F>* out, const T<B, F>* a, const T<B, F>* b, Func&& func
+	) {
+		const D<B, F> d;
+		ForEachVector<B, F>(count, [&](int i) {
+			hn::Store(func(hn::Load(d, a + i), hn::Load(d, b + i)), d, out + i);
+		});
+	}
+
+	template <size_t B, size_t F, typename Func>
+	HWY_INLINE void NoiseProgramMap(
+		int count, T<B, F>* out, const T<B, F>* a, const T<B, F>* b, const T<B, F>* c,
+		Func&& func
+	) {
+		const D<B, F> d;
+		ForEachVector<B, F>(count, [&](int i) {
+			hn::Store(
+				func(hn::Load(d, a + i), hn::Load(d, b + i), hn::Load(d, c + i)), d, out + i);
+		});
+	}
+
+	// Runs a sampling function over the coordinates of the instruction, in 2D or 3D.
+	template <size_t B, size_t F, typename Func2D, typename Func3D>
+	HWY_INLINE void NoiseProgramSample(
+		int count, const NoiseInstruction<B, F>& instruction, T<B, F>** registers,
+		Func2D&& func2D, Func3D&& func3D
+	) {
+		T<B, F>* out = registers[instruction.Out];
+		const T<B, F>* x = registers[instruction.In[0]];
+		const T<B, F>* y = registers[instruction.In[1]];
+
+		if (instruction.In[2] >= 0) {
+			NoiseProgramMap<B, F>(count, out, x, y, registers[instruction.In[2]], func3D);
+		}
+		else {
+			NoiseProgramMap<B, F>(count, out, x, y, func2D);
+		}
+	}
+
+	template <size_t B, size_t F, size_t Feature>
+	HWY_INLINE void NoiseProgramCellular(
+		const NoiseBlock<B, F>& block, int count, const NoiseInstruction<B, F>& instruction,
+		T<B, F>** registers
+	) {
+		using vec = V<B, F>;
+		const FixedPoint<B, F> seed = instruction.Params[0];
+		const unsigned int points = instruction.Count;
+
+		const CellularCache<B, F>* cache = instruction.Node ?
+			static_cast<const CellularNode<B, F, Feature>*>(instruction.Node)->FindCache(
+				block.Context
+			) : nullptr;
+
+		if (cache) {
+			NoiseProgramSample<B, F>(count, instruction, registers,
+				[&](vec x, vec y) { return Cellular<B, F, Feature>(x, y, seed, points, *cache); },
+				[&](vec x, vec y, vec z) {
+					return Cellular<B, F, Feature>(x, y, z, seed, points, *cache);
+				}
+			);
+			return;
+		}
+
+		NoiseProgramSample<B, F>(count, instruction, registers,
+			[&](vec x, vec y) { return Cellular<B, F, Feature>(x, y, seed, points); },
+			[&](vec x, vec y, vec z) { return Cellular<B, F, Feature>(x, y, z, seed, points); }
+		);
+	}
+
+	// Same as NoiseProgramSample(), for a block of grid samples. Vectors within a row of the grid
+	// combine the lattice values of their row and columns with row2D(lattice, ix, iy) or
+	// row3D(lattice, ix, iy, iz), instead of sampling their coordinates.
+	template <
+		size_t B, size_t F, typename Row2D, typename Row3D, typename Func2D, typename Func3D
+	>
+	HWY_INLINE void NoiseProgramGridSample(
+		const NoiseBlock<B, F>& block, const NoiseInstruction<B, F>& instruction,
+		const NoiseProgramGrid<B, F>& grid, const NoiseGridLattice<B, F>& lattice,
+		T<B, F>** registers, Row2D&& row2D, Row3D&& row3D, Func2D&& func2D, Func3D&& func3D
+	) {
+		const D<B, F> d;
+		T<B, F>* out = registers[instruction.Out];
+		const T<B, F>* x = registers[instruction.In[0]];
+		const T<B, F>* y = registers[instruction.In[1]];
+
+		if (instruction.In[2] >= 0) {
+			const T<B, F>* z = registers[instruction.In[2]];
+
+			ForEachGridVector<B, F>(grid.Params, block.Begin, block.Count,
+				[&](int i, int ix, int iy, int iz) {
+					hn::Store(row3D(lattice, ix, iy, iz), d, out + i);
+				},
+				[&](int i) {
+					hn::Store(func3D(hn::Load(d, x + i), hn::Load(d, y + i), hn::Load(d, z + i)),
+						d, out + i);
+				}
+			);
+		}
+		else {
+			ForEachGridVector<B, F>(grid.Params, block.Begin, block.Count,
+				[&](int i, int ix, int iy, int iz) {
+					hn::Store(row2D(lattice, ix, iy), d, out + i);
+				},
+				[&](int i) {
+					hn::Store(func2D(hn::Load(d, x + i), hn::Load(d, y + i)), d, out + i);
+				}
+			);
+		}
+	}
+
+	// Writes the Perlin lattice values of an axis, from the coordinates of its samples, as 5
+	// channels: the hash terms, offsets and fade of GetPerlinAxis(). Count and Index are those
+	// of the coordinate's HashTerm(). The seed is added to the last axis'.
+	template <size_t B, size_t F, size_t Count, size_t Index>
+	void NoiseProgramPerlinLattice(
+		FixedPoint<B, F> seed, const T<B, F>* coordinates, int size, T<B, F>* values, int stride
+	) {
+		using vec = V<B, F>;
+		using uvec = UV<B, F>;
+
+		const D<B, F> d;
+		const uvec seedTerm = (Index == Count - 2) ?
+			PerlinSeedTerm<B, F, Count>(seed) : Zero<uvec>();
+
+		ForEachVector<B, F>(size, [&](int i) {
+			uvec hash0, hash1;
+			vec delta0, delta1, fade;
+			GetPerlinAxis<B, F, Count, Index>(
+				hn::Load(d, coordinates + i), seedTerm, hash0, hash1, delta0, delta1, fade);
+
+			hn::Store(Reinterpret<vec>(hash0), d, values + i);
+			hn::Store(Reinterpret<vec>(hash1), d, values + stride + i);
+			hn::Store(delta0, d, values + 2 * stride + i);
+			hn::Store(delta1, d, values + 3 * stride + i);
+			hn::Store(fade, d, values + 4 * stride + i);
+		});
+	}
+
+	template <size_t B, size_t F>
+	void NoiseProgram<B, F>::BuildGrid(
+		const NoiseSamplingParameters<B, F>& params, NoiseProgramGrid<B, F>& grid
+	) const {
+		using vec = V<B, F>;
+
+		const int dimensions = params.GetDimensions();
+		grid.Params = params;
+		grid.Lattices.clear();
+		grid.Lattices.resize(Instructions.size());
+
+		if (dimensions != 2 && dimensions != 3) {
+			return;
+		}
+
+		// Registers that only depend on a single axis of the grid: the axis, and the instructions
+		// that compute the register from the axis' coordinates. Axis is -1 for the others.
+		struct AxisRegister
+		{
+			int Axis = -1;
+			std::vector<int> Ops;
+		};
+
+		std::vector<AxisRegister> axisRegisters(RegisterCount);
+
+		for (int a = 0; a < dimensions; ++a) {
+			axisRegisters[InputX + a].Axis = a;
+		}
+
+		// By dimensions, then axis
+		using LatticeFunc = void (*)(FixedPoint<B, F>, const T<B, F>*, int, T<B, F>*, int);
+		static constexpr LatticeFunc PerlinLattices[2][3] = {
+			{ &NoiseProgramPerlinLattice<B, F, 3, 0>, &NoiseProgramPerlinLattice<B, F, 3, 1> },
+			{
+				&NoiseProgramPerlinLattice<B, F, 4, 0>, &NoiseProgramPerlinLattice<B, F, 4, 1>,
+				&NoiseProgramPerlinLattice<B, F, 4, 2>
+			},
+		};
+
+		const D<B, F> d;
+		const T<B, F> spacing = params.Spacing.ToRaw();
+		AlignedArray<T<B, F>> coordinates;
+
+		for (int k = 0; k < int(Instructions.size()); ++k) {
+			const NoiseInstruction<B, F>& instruction = Instructions[k];
+			const bool is3D = (instruction.In[2] >= 0);
+			bool isSampledOnAxes = (instruction.Op == NoiseOp::Perlin) &&
+				is3D == (dimensions == 3);
+
+			for (int a = 0; a < dimensions && isSampledOnAxes; ++a) {
+				isSampledOnAxes = (axisRegisters[instruction.In[a]].Axis == a);
+			}
+
+			if (isSampledOnAxes) {
+				NoiseGridLattice<B, F>& lattice = grid.Lattices[k];
+				const int channelCount = 5;	// See NoiseProgramPerlinLattice()
+
+				for (int a = 0; a < dimensions; ++a) {
+					const int size = params.Size(a);
+					const int stride = int(hwy::RoundUpTo(size, hn::Lanes(d)));
+					const T<B, F> start = params.Start(a).ToRaw();
+
+					lattice.Strides[a] = stride;
+					lattice.Axes[a].EnsureSize(channelCount * stride);
+					coordinates.EnsureSize(stride);
+
+					// Coordinates along the axis, as generated by GenerateGridCoordinates(), then
+					// scaled and offset by the same ops as in Run().
+					ForEachVector<B, F>(size, [&](int i) {
+						vec value = sn::Add(sn::Mul(hn::Iota(d, i), spacing), start);
+
+						for (int op : axisRegisters[instruction.In[a]].Ops) {
+							const FixedPoint<B, F> p0 = Instructions[op].Params[0];
+
+							value = (Instructions[op].Op == NoiseOp::Scale) ?
+								FPMul<B, F>(value, FPBroadcast<B, F>(p0)) :
+								FPAdd<B, F>(value, p0);
+						}
+
+						hn::Store(value, d, coordinates.GetPtr() + i);
+					});
+
+					PerlinLattices[dimensions - 2][a](instruction.Params[0],
+						coordinates.GetPtr(), size, lattice.Axes[a].GetPtr(), stride);
+				}
+
+				lattice.IsValid = true;
+			}
+
+			// Scaling and offsetting a coordinate keeps it along its axis.
+			AxisRegister out;
+
+			if (instruction.Op == NoiseOp::Scale || instruction.Op == NoiseOp::AddConstant) {
+				out = axisRegisters[instruction.In[0]];
+				if (out.Axis >= 0) out.Ops.push_back(k);
+			}
+
+			axisRegisters[instruction.Out] = std::move(out);
+		}
+	}
+
+	// *********************************************************************************************
+	// Interpreter
+	template <size_t B, size_t F>
+	void NoiseProgram<B, F>::Run(
+		const NoiseBlock<B, F>& block, T<B, F>* const* outputs, const NoisePlane<B, F>* plane,
+		const NoiseProgramGrid<B, F>* grid
+	) const {
+		using vec = V<B, F>;
+		using fp = FixedPoint<B, F>;
+		using fpc = FixedPointConstant<B, F>;
+
+		const int count = block.Count;
+
+		// Register table. Graphs rarely need more than a handful of live values at a time, so the
+		// table normally stays on the stack.
+		constexpr int InlineRegisterCount = 32;
+		T<B, F>* inlineRegisters[InlineRegisterCount];
+		std::vector<T<B, F>*> heapRegisters;
+		T<B, F>** registers = inlineRegisters;
+
+		if (RegisterCount > InlineRegisterCount) {
+			heapRegisters.resize(RegisterCount);
+			registers = heapRegisters.data();
+		}
+
+		// Inputs are never written to.
+		registers[InputX] = const_cast<T<B, F>*>(block.X);
+		registers[InputY] = const_cast<T<B, F>*>(block.Y);
+		registers[InputZ] = const_cast<T<B, F>*>(block.Z);
+
+		for (int j = 0; j < OutputCount; ++j) {
+			registers[Output + j] = outputs[j];
+		}
+
+		for (int r = GetFirstScratch(); r < RegisterCount; ++r) {
+			registers[r] = BlockScratch<B, F>::Push();
+		}
+
+		if (block.Begin < 0) {
+			grid = nullptr;
+		}
+
+		assert(!grid || grid->Lattices.size() == Instructions.size());
+
+		for (int k = 0; k < int(Instructions.size()); ++k) {
+			const NoiseInstruction<B, F>& instruction = Instructions[k];
+			const NoiseGridLattice<B, F>* lattice = grid ? &grid->Lattices[k] : nullptr;
+			T<B, F>* dst = registers[instruction.Out];
+			const T<B, F>* a = (instruction.In[0] >= 0) ? registers[instruction.In[0]] : nullptr;
+			const T<B, F>* b = (instruction.In[1] >= 0) ? registers[instruction.In[1]] : nullptr;
+			const fp p0 = instruction.Params[0];
+			const fp p1 = instruction.Params[1];
+
+			switch (instruction.Op) {
+			case NoiseOp::Zero: {
+				const D<B, F> d;
+				ForEachVector<B, F>(count, [&](int i) {
+					hn::Store(Zero<vec>(), d, dst + i);
+				});
+				break;
+			}
+
+			case NoiseOp::Call: {
+				const int zRegister = instruction.In[2];
+				const T<B, F>* c = (zRegister >= 0) ? registers[zRegister] : nullptr;
+				instruction.Node->Evaluate(block.WithCoordinates(a, b, c), dst);
+				break;
+			}
+
+			case NoiseOp::Random:
+				NoiseProgramSample<B, F>(count, instruction, registers,
+					[&](vec x, vec y) { return Random<B, F>(x, y, p0); },
+					[&](vec x, vec y, vec z) { return Random<B, F>(x, y, z, p0); }
+				);
+				break;
+
+			case NoiseOp::Perlin: {
+				auto perlin2D = [&](vec x, vec y) { return Perlin<B, F>(x, y, p0); };
+				auto perlin3D = [&](vec x, vec y, vec z) { return Perlin<B, F>(x, y, z, p0); };
+
+				if (!lattice || !lattice->IsValid) {
+					NoiseProgramSample<B, F>(count, instruction, registers, perlin2D, perlin3D);
+					break;
+				}
+
+				// Columns are loaded, rows (and slices) are the same for the whole vector.
+				const D<B, F> d;
+
+				auto ColumnLambda = [&](const NoiseGridLattice<B, F>& l, int c, int ix) {
+					return hn::LoadU(d, l.GetChannel(0, c) + ix);
+				};
+
+				auto RowLambda = [&](const NoiseGridLattice<B, F>& l, int axis, int c, int i) {
+					return hn::Set(d, l.GetChannel(axis, c)[i]);
+				};
+
+				using uvec = UV<B, F>;
+
+				NoiseProgramGridSample<B, F>(block, instruction, *grid, *lattice, registers,
+					[&](const NoiseGridLattice<B, F>& l, int ix, int iy) {
+						return PerlinFromAxes<B, F>(
+							Reinterpret<uvec>(ColumnLambda(l, 0, ix)),
+							Reinterpret<uvec>(ColumnLambda(l, 1, ix)),
+							ColumnLambda(l, 2, ix), ColumnLambda(l, 3, ix), ColumnLambda(l, 4, ix),
+							Reinterpret<uvec>(RowLambda(l, 1, 0, iy)),
+							Reinterpret<uvec>(RowLambda(l, 1, 1, iy)),
+							RowLambda(l, 1, 2, iy), RowLambda(l, 1, 3, iy), RowLambda(l, 1, 4, iy)
+						);
+					},
+					[&](const NoiseGridLattice<B, F>& l, int ix, int iy, int iz) {
+						return PerlinFromAxes<B, F>(
+							Reinterpret<uvec>(ColumnLambda(l, 0, ix)),
+							Reinterpret<uvec>(ColumnLambda(l, 1, ix)),
+							ColumnLambda(l, 2, ix), ColumnLambda(l, 3, ix), ColumnLambda(l, 4, ix),
+							Reinterpret<uvec>(RowLambda(l, 1, 0, iy)),
+							Reinterpret<uvec>(RowLambda(l, 1, 1, iy)),
+							RowLambda(l, 1, 2, iy), RowLambda(l, 1, 3, iy), RowLambda(l, 1, 4, iy),
+							Reinterpret<uvec>(RowLambda(l, 2, 0, iz)),
+							Reinterpret<uvec>(RowLambda(l, 2, 1, iz)),
+							RowLambda(l, 2, 2, iz), RowLambda(l, 2, 3, iz), RowLambda(l, 2, 4, iz)
+						);
+					},
+					perlin2D, perlin3D
+				);
+				break;
+			}
+
+			case NoiseOp::Simplex:
+				NoiseProgramSample<B, F>(count, instruction, registers,
+					[&](vec x, vec y) { return Simplex<B, F>(x, y, p0); },
+					[&](vec x, vec y, vec z) { return Simplex<B, F>(x, y, z, p0); }
+				);
+				break;
+
+			case NoiseOp::Cellular0:
+				NoiseProgramCellular<B, F, 0>(block, count, instruction, registers);
+				break;
+
+			case NoiseOp::Cellular1:
+				NoiseProgramCellular<B, F, 1>(block, count, instruction, registers);
+				break;
+
+			case NoiseOp::Cellular2:
+				NoiseProgramCellular<B, F, 2>(block, count, instruction, registers);
+				break;
+
+			case NoiseOp::Scale: {
+				const vec scale = FPBroadcast<B, F>(p0);
+				NoiseProgramMap<B, F>(count, dst, a, [&](vec value) {
+					return FPMul<B, F>(value, scale);
+				});
+				break;
+			}
+
+			case NoiseOp::AddConstant:
+				NoiseProgramMap<B, F>(count, dst, a, [&](vec value) {
+					return FPAdd<B, F>(value, p0);
+				});
+				break;
+
+			case NoiseOp::FractalAccumulate:
+				NoiseProgramMap<B, F>(count, dst, a, b, [&](vec value, vec sample) {
+					return FPAdd<B, F>(
+						value, FPMul<B, F>(FPSub<B, F>(hn::ShiftLeft<1>(sample), 1), p0));
+				});
+				break;
+
+			case NoiseOp::FractalNormalize:
+				NoiseProgramMap<B, F>(count, dst, a, [&](vec value) {
+					// Scale from [-mv, mv] to [-0.5, 0.5], then shift to [0, 1]
+					value = FPDiv<B, F>(value, p0 << 1);
+					return FPAdd<B, F>(value, fp(1) >> 1);
+				});
+				break;
+
+			case NoiseOp::WarpAccumulate:
+				NoiseProgramMap<B, F>(count, dst, a, b, [&](vec value, vec shift) {
+					return FPAdd<B, F>(
+						value, FPMul<B, F>(p0, FPSub<B, F>(hn::ShiftLeft<1>(shift), 1)));
+				});
+				break;
+
+			case NoiseOp::OneMinus:
+				NoiseProgramMap<B, F>(count, dst, a, [&](vec value) {
+					return FPSub<B, F>(fpc::One, value);
+				});
+				break;
+
+			case NoiseOp::Ridge:
+				NoiseProgramMap<B, F>(count, dst, a, [&](vec value) {
+					return hn::Abs(hn::ShiftRight<1>(FPAdd<B, F>(fpc::One, value)));
+				});
+				break;
+
+			case NoiseOp::HeightBias:
+				NoiseProgramMap<B, F>(count, dst, a, b, [&](vec value, vec z) {
+					vec bias = FPDiv<B, F>(FPSub<B, F>(z, p1), p0 - p1);
+					bias = FPClamp<B, F>(bias, 0, fpc::One);
+					return sn::Max(sn::Sub(value, bias), Zero<vec>());
+				});
+				break;
+
+			case NoiseOp::LoadPlane: {
+				// Flattened indices wrap around the plane once per z slice. Whole vectors are
+				// loaded, like every other instruction writes, so the lanes past count aren't
+				// left stale.
+				assert(plane && block.Begin >= 0);
+				const T<B, F>* values = plane->Values[instruction.Count].GetPtr();
+				const D<B, F> d;
+				const int laneCount = hn::Lanes(d);
+				int column = block.Begin % plane->Size;
+
+				ForEachVector<B, F>(count, [&](int i) {
+					if (column + laneCount <= plane->Size) {
+						hn::Store(hn::LoadU(d, values + column), d, dst + i);
+					}
+					else {
+						// The vector continues at the start of the plane (the next z slice).
+						for (int lane = 0; lane < laneCount; ++lane) {
+							dst[i + lane] = values[(column + lane) % plane->Size];
+						}
+					}
+
+					column += laneCount;
+					if (column >= plane->Size) column %= plane->Size;
+				});
+				break;
+			}
+			}
+		}
+
+		for (int j = 0; j < int(OutputAliases.size()); ++j) {
+			if (OutputAliases[j] < 0) continue;
+
+			NoiseProgramMap<B, F>(count, outputs[j], outputs[OutputAliases[j]], [](vec value) {
+				return value;
+			});
+		}
+
+		for (int r = GetFirstScratch(); r < RegisterCount; ++r) {
+			BlockScratch<B, F>::Pop();
+		}
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
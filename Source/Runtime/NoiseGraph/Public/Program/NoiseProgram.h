@@ -0,0 +1,543 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Google Highway requirement
+#if defined(NOISEGRAPH_PROGRAM_PROGRAM_SIMD_H_) == defined(HWY_TARGET_TOGGLE)
+#ifdef NOISEGRAPH_PROGRAM_PROGRAM_SIMD_H_
+#undef NOISEGRAPH_PROGRAM_PROGRAM_SIMD_H_
+#else
+#define NOISEGRAPH_PROGRAM_PROGRAM_SIMD_H_
+#endif
+
+#include "hwy/highway.h"
+#include "Numerics/FixedPoint.h"
+#include "Numerics/FixedPointSIMD.h"
+#include "Nodes/NoiseBlock.h"
+#include "NoiseAxes.h"
+#include "NoiseSamplingParameters.h"
+#include "AlignedArray.h"
+#include <cassert>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	template <size_t B, size_t F>
+	class NodeBaseSIMD;
+
+	// Operations of the noise program. Every operation writes a single block of values.
+	enum class NoiseOp : uint8_t
+	{
+		Zero,				// 0
+		Call,				// Node->Evaluate(In[0], In[1], In[2])
+		Random,				// Random(In[0], In[1], In[2], Params[0] seed)
+		Perlin,				// Perlin(In[0], In[1], In[2], Params[0] seed)
+		Simplex,			// Simplex(In[0], In[1], In[2], Params[0] seed)
+		Cellular0,			// Cellular<0>(In[0], In[1], In[2], Params[0] seed, Count points), with
+							// the feature points cached by the CellularNode Node, if any
+		Cellular1,			// Cellular<1>(...)
+		Cellular2,			// Cellular<2>(...)
+		Scale,				// In[0] * Params[0]
+		AddConstant,		// In[0] + Params[0]
+		FractalAccumulate,	// In[0] + (2 * In[1] - 1) * Params[0] amplitude
+		FractalNormalize,	// In[0] / (2 * Params[0] max value) + 0.5
+		WarpAccumulate,		// In[0] + (2 * In[1] - 1) * Params[0] strength
+		OneMinus,			// 1 - In[0]
+		Ridge,				// |(1 + In[0]) / 2|
+		HeightBias,			// max(In[0] - clamp((In[1] - lower) / (upper - lower)), 0)
+		LoadPlane,			// Value Count of the NoisePlane, at the block's samples
+	};
+
+	template <size_t B, size_t F>
+	struct NoiseInstruction
+	{
+		NoiseOp Op;
+		int Out = -1;
+		int In[3] = { -1, -1, -1 };		// -1 if unused. In[2] is -1 for 2D coordinates.
+		FixedPoint<B, F> Params[2] = { FixedPoint<B, F>(0), FixedPoint<B, F>(0) };
+		unsigned int Count = 0;
+		const NodeBaseSIMD<B, F>* Node = nullptr;	// Node called, or whose state is used
+	};
+
+	// Values of a program's z-invariant registers over the XY plane of a 3D grid. 
+	// Values[j] holds plane output j for every (x, y) column, in the grid's flattened order. 
+	template <size_t B, size_t F>
+	struct NoisePlane
+	{
+		std::vector<AlignedArray<T<B, F>>> Values;
+		int Size = 0;
+	};
+
+	// Lattice values of a sampling instruction along each axis of a grid. Lattice values (e.g.
+	// Perlin's floors, fades and hash terms) only depend on one coordinate each, so they're
+	// computed once per row and column rather than for every sample. Only built for Perlin
+	// instructions whose coordinates each depend on a single axis of the grid (e.g. the scaled
+	// coordinates of a fractal's octaves).
+	// Channel c of axis a at index i is Axes[a][c * Strides[a] + i].
+	template <size_t B, size_t F>
+	struct NoiseGridLattice
+	{
+		AlignedArray<T<B, F>> Axes[3];
+		int Strides[3] = {};
+		bool IsValid = false;
+
+		const T<B, F>* GetChannel(int axis, int channel) const {
+			return Axes[axis].GetPtr() + channel * Strides[axis];
+		}
+	};
+
+	// Lattices of a program's instructions over a grid, built by NoiseProgram::BuildGrid().
+	template <size_t B, size_t F>
+	struct NoiseProgramGrid
+	{
+		NoiseSamplingParameters<B, F> Params;
+		std::vector<NoiseGridLattice<B, F>> Lattices;	// Per instruction
+	};
+
+	// A node graph lowered into a flat list of instructions over block-sized registers.
+	// Node parameters are inlined into the instructions, so running the program doesn't touch the
+	// nodes at all, except for nodes that can't be lowered (called through NoiseOp::Call).
+	//
+	// Registers:
+	//		0, 1, 2 - the block's X, Y, Z coordinates (read-only)
+	//		3+		- the output arrays (a single one, except for plane programs)
+	//		...		- scratch buffers, taken from the thread's BlockScratch
+	template <size_t B, size_t F>
+	class NoiseProgram
+	{
+	public:
+		static constexpr int InputX = 0;
+		static constexpr int InputY = 1;
+		static constexpr int InputZ = 2;
+		static constexpr int Output = 3;
+
+		// Runs the program over the block. Defined in NoiseInterpreter.h
+		void Run(const NoiseBlock<B, F>& block, T<B, F>* out) const {
+			Run(block, &out, nullptr);
+		}
+
+		// Same as above, with an array per output. Programs with a Plane read its values from 
+		// plane, which must have been built by running Plane over the block's grid. 
+		// Blocks of samples on a grid (NoiseBlock::Begin >= 0) can also be given the grid's
+		// lattices, which must have been built by BuildGrid() over the same grid.
+		void Run(
+			const NoiseBlock<B, F>& block, T<B, F>* const* outputs, const NoisePlane<B, F>* plane,
+			const NoiseProgramGrid<B, F>* grid = nullptr
+		) const;
+
+		// Builds the lattices of the instructions that sample the grid along its axes.
+		// Defined in NoiseInterpreter.h
+		void BuildGrid(
+			const NoiseSamplingParameters<B, F>& params, NoiseProgramGrid<B, F>& grid
+		) const;
+
+		int GetFirstScratch() const {
+			return Output + OutputCount;
+		}
+
+		std::vector<NoiseInstruction<B, F>> Instructions;
+		int OutputCount = 1;
+		int RegisterCount = Output + 1;
+
+		// Outputs that are the same value as an earlier output (e.g. the same node under two 
+		// names). OutputAliases[j] is the earlier output, or -1. Empty if there are none. 
+		std::vector<int> OutputAliases;
+
+		// The z-invariant part of a 3D program, which only needs to run once per XY column. 
+		// Its outputs are the values the program reads with NoiseOp::LoadPlane. 
+		// nullptr if the program was built without one.
+		std::shared_ptr<const NoiseProgram> Plane;
+	};
+
+	// Lowers nodes into a NoiseProgram. Nodes emit their instructions through
+	// NodeBaseSIMD::Compile(), which returns the register holding the node's value.
+	//
+	// While building, every instruction writes to its own (virtual) register, which lets nodes
+	// freely reuse values. Finish() then maps the virtual registers onto as few block buffers as
+	// possible, so that the working set of a program stays small.
+	//
+	// Instructions are hash-consed: emitting an instruction identical to an existing one (same op,
+	// inputs and parameters) returns the existing register instead. Since every instruction is a
+	// pure function of its inputs, a subgraph that is plugged into several places (e.g. the same
+	// key as the base and shift of a warp) is only evaluated once per block.
+	//
+	// The builder also tracks which axes every register depends on. 3D programs can then move the 
+	// registers that don't depend on z into a separate plane program (see FinishPlanar()). 
+	template <size_t B, size_t F>
+	class NoiseProgramBuilder
+	{
+		using fp = FixedPoint<B, F>;
+
+	public:
+		// Registers of the coordinates a node is sampled at. Z is -1 for 2D.
+		struct Coordinates
+		{
+			int X;
+			int Y;
+			int Z;
+
+			bool Is3D() const {
+				return Z >= 0;
+			}
+		};
+
+		NoiseProgramBuilder(size_t dimensions) : Dimensions(dimensions) {}
+
+		// Compiles the node graph into a program for the given number of dimensions.
+		// If planar, z-invariant values of 3D programs are moved into a plane program.
+		static NoiseProgram<B, F> Build(
+			const NodeBaseSIMD<B, F>& root, size_t dimensions, bool planar = false
+		) {
+			return Build({ &root }, dimensions, planar);
+		}
+
+		// Same as above, with an output per root. The roots are compiled into the same program,
+		// so the subgraphs they share are only evaluated once. 
+		static NoiseProgram<B, F> Build(
+			const std::vector<const NodeBaseSIMD<B, F>*>& roots, size_t dimensions, 
+			bool planar = false
+		) {
+			NoiseProgramBuilder builder(dimensions);
+			std::vector<int> results;
+
+			for (const NodeBaseSIMD<B, F>* root : roots) {
+				results.push_back(root->Compile(builder, builder.GetInputs()));
+			}
+
+			if (planar && dimensions == 3) {
+				return builder.FinishPlanar(results);
+			}
+
+			return builder.Finish(results);
+		}
+
+		Coordinates GetInputs() const {
+			return Coordinates{
+				NoiseProgram<B, F>::InputX,
+				NoiseProgram<B, F>::InputY,
+				(Dimensions == 3) ? NoiseProgram<B, F>::InputZ : -1
+			};
+		}
+
+		// Appends an instruction, and returns the register it writes to.
+		int Emit(
+			NoiseOp op, std::initializer_list<int> inputs,
+			fp param0 = fp(0), fp param1 = fp(0), unsigned int count = 0
+		) {
+			NoiseInstruction<B, F> instruction;
+			instruction.Op = op;
+			instruction.Params[0] = param0;
+			instruction.Params[1] = param1;
+			instruction.Count = count;
+
+			int i = 0;
+			for (int input : inputs) {
+				assert(i < 3);
+				instruction.In[i++] = input;
+			}
+
+			return Append(instruction);
+		}
+
+		// Shorthand for instructions that sample at a set of coordinates.
+		int EmitSample(
+			NoiseOp op, const Coordinates& coords, fp param0 = fp(0), unsigned int count = 0,
+			const NodeBaseSIMD<B, F>* node = nullptr
+		) {
+			NoiseInstruction<B, F> instruction;
+			instruction.Op = op;
+			instruction.In[0] = coords.X;
+			instruction.In[1] = coords.Y;
+			instruction.In[2] = coords.Z;
+			instruction.Params[0] = param0;
+			instruction.Count = count;
+			instruction.Node = node;
+			return Append(instruction);
+		}
+
+		// Fallback for nodes that can't be lowered. The node is evaluated as is.
+		int EmitCall(const NodeBaseSIMD<B, F>& node, const Coordinates& coords) {
+			NoiseInstruction<B, F> instruction;
+			instruction.Op = NoiseOp::Call;
+			instruction.In[0] = coords.X;
+			instruction.In[1] = coords.Y;
+			instruction.In[2] = coords.Z;
+			instruction.Node = &node;
+			return Append(instruction);
+		}
+
+		// Allocates the registers, and returns the program which writes results[j] to output j.
+		NoiseProgram<B, F> Finish(const std::vector<int>& results) const {
+			return Allocate(Instructions, results);
+		}
+
+		// Same as Finish(), but the instructions that don't depend on z are moved into the plane 
+		// program. The main program then loads the plane values it needs, instead of computing 
+		// them for every sample of a column. 
+		// Returns a normal program if there is nothing expensive to move.
+		NoiseProgram<B, F> FinishPlanar(const std::vector<int>& results) const {
+			const int count = int(Instructions.size());
+
+			auto IsPlanarLambda = [&](int v) {
+				return v >= InputCount && !HasAnyAxis(Axes[v - InputCount], NoiseAxes::Z);
+			};
+
+			// Only noise functions and calls are worth computing once per column.
+			auto IsExpensiveLambda = [](NoiseOp op) {
+				return op == NoiseOp::Call || op == NoiseOp::Random || op == NoiseOp::Perlin ||
+					op == NoiseOp::Simplex ||
+					op == NoiseOp::Cellular0 || op == NoiseOp::Cellular1 || 
+					op == NoiseOp::Cellular2;
+			};
+
+			// Plane values read by the rest of the program
+			std::vector<bool> isLoaded(count + InputCount, false);
+			bool hasLoads = false;
+			bool hasExpensive = false;
+
+			for (int k = 0; k < count; ++k) {
+				if (IsPlanarLambda(k + InputCount)) {
+					hasExpensive |= IsExpensiveLambda(Instructions[k].Op);
+					continue;
+				}
+
+				for (int input : Instructions[k].In) {
+					if (IsPlanarLambda(input)) {
+						isLoaded[input] = true;
+						hasLoads = true;
+					}
+				}
+			}
+
+			for (int result : results) {
+				if (IsPlanarLambda(result)) {
+					isLoaded[result] = true;
+					hasLoads = true;
+				}
+			}
+
+			if (!hasLoads || !hasExpensive) {
+				return Finish(results);
+			}
+
+			// Splits the instructions, and renumbers the virtual registers of each half.
+			std::vector<NoiseInstruction<B, F>> plane;
+			std::vector<NoiseInstruction<B, F>> volume;
+			std::vector<int> planeOutputs;
+			std::vector<int> planeRegister(count + InputCount, -1);
+			std::vector<int> volumeRegister(count + InputCount, -1);
+
+			for (int i = 0; i < InputCount; ++i) {
+				planeRegister[i] = i;
+				volumeRegister[i] = i;
+			}
+
+			for (int k = 0; k < count; ++k) {
+				const int v = k + InputCount;
+				NoiseInstruction<B, F> instruction = Instructions[k];
+
+				if (IsPlanarLambda(v)) {
+					for (int& input : instruction.In) {
+						if (input >= 0) input = planeRegister[input];
+					}
+
+					plane.push_back(instruction);
+					planeRegister[v] = int(plane.size()) - 1 + InputCount;
+
+					if (isLoaded[v]) {
+						NoiseInstruction<B, F> load;
+						load.Op = NoiseOp::LoadPlane;
+						load.Count = static_cast<unsigned int>(planeOutputs.size());
+						planeOutputs.push_back(planeRegister[v]);
+
+						volume.push_back(load);
+						volumeRegister[v] = int(volume.size()) - 1 + InputCount;
+					}
+				}
+				else {
+					for (int& input : instruction.In) {
+						if (input >= 0) input = volumeRegister[input];
+					}
+
+					volume.push_back(instruction);
+					volumeRegister[v] = int(volume.size()) - 1 + InputCount;
+				}
+			}
+
+			std::vector<int> volumeResults;
+			for (int result : results) {
+				volumeResults.push_back(volumeRegister[result]);
+			}
+
+			NoiseProgram<B, F> program = Allocate(volume, volumeResults);
+			program.Plane = std::make_shared<const NoiseProgram<B, F>>(
+				Allocate(plane, planeOutputs));
+			return program;
+		}
+
+	private:
+		static constexpr int InputCount = 3;
+
+		// Maps the virtual registers of the instructions onto as few physical registers as 
+		// possible. Instruction k writes virtual register k + InputCount. outputs[j] is written to
+		// the program's output j.
+		static NoiseProgram<B, F> Allocate(
+			const std::vector<NoiseInstruction<B, F>>& instructions, 
+			const std::vector<int>& outputs
+		) {
+			const int virtualCount = int(instructions.size()) + InputCount;
+
+			// Last instruction that reads each virtual register
+			std::vector<int> lastUse(virtualCount, -1);
+			for (int k = 0; k < int(instructions.size()); ++k) {
+				for (int input : instructions[k].In) {
+					if (input >= 0) lastUse[input] = k;
+				}
+			}
+
+			NoiseProgram<B, F> program;
+
+			// Output index of each virtual register, -1 if it's not an output. Registers that 
+			// are several outputs are written to the first one, and copied to the others.
+			std::vector<int> outputIndex(virtualCount, -1);
+			for (int j = 0; j < int(outputs.size()); ++j) {
+				// Nodes always write their value with an instruction.
+				assert(outputs[j] >= InputCount);
+
+				if (outputIndex[outputs[j]] < 0) {
+					outputIndex[outputs[j]] = j;
+					continue;
+				}
+
+				program.OutputAliases.resize(outputs.size(), -1);
+				program.OutputAliases[j] = outputIndex[outputs[j]];
+			}
+
+			std::vector<int> physical(virtualCount, -1);
+			physical[NoiseProgram<B, F>::InputX] = NoiseProgram<B, F>::InputX;
+			physical[NoiseProgram<B, F>::InputY] = NoiseProgram<B, F>::InputY;
+			physical[NoiseProgram<B, F>::InputZ] = NoiseProgram<B, F>::InputZ;
+
+			program.OutputCount = int(outputs.size());
+			program.RegisterCount = program.GetFirstScratch();
+			std::vector<int> freeRegisters;
+
+			for (int k = 0; k < int(instructions.size()); ++k) {
+				NoiseInstruction<B, F> instruction = instructions[k];
+				const int v = k + InputCount;
+
+				// Returns the scratch registers of inputs that are no longer needed after k.
+				auto ReleaseInputsLambda = [&]() {
+					for (int i = 0; i < 3; ++i) {
+						const int input = instructions[k].In[i];
+						bool isDuplicate = false;
+
+						for (int j = 0; j < i; ++j) {
+							isDuplicate |= (instructions[k].In[j] == input);
+						}
+
+						if (input >= InputCount && outputIndex[input] < 0 &&
+							lastUse[input] == k && !isDuplicate) {
+							freeRegisters.push_back(physical[input]);
+						}
+					}
+				};
+
+				for (int& input : instruction.In) {
+					if (input >= 0) input = physical[input];
+				}
+
+				// Elementwise ops read a vector before writing it, so they can write over their
+				// inputs. Calls can't, since a node may write its output before it is done
+				// reading the coordinates.
+				if (instruction.Op != NoiseOp::Call) {
+					ReleaseInputsLambda();
+				}
+
+				if (outputIndex[v] >= 0) {
+					physical[v] = NoiseProgram<B, F>::Output + outputIndex[v];
+				}
+				else if (!freeRegisters.empty()) {
+					physical[v] = freeRegisters.back();
+					freeRegisters.pop_back();
+				}
+				else {
+					physical[v] = program.RegisterCount++;
+				}
+
+				if (instruction.Op == NoiseOp::Call) {
+					ReleaseInputsLambda();
+				}
+
+				// Unused value
+				if (lastUse[v] < 0 && outputIndex[v] < 0) {
+					freeRegisters.push_back(physical[v]);
+				}
+
+				instruction.Out = physical[v];
+				program.Instructions.push_back(instruction);
+			}
+
+			return program;
+		}
+
+		// Axes that register depends on.
+		NoiseAxes GetAxes(int reg) const {
+			return (reg < InputCount) ? NoiseAxisAt(reg) : Axes[reg - InputCount];
+		}
+
+		using InstructionKey = std::tuple<
+			NoiseOp, int, int, int, T<B, F>, T<B, F>, unsigned int, const NodeBaseSIMD<B, F>*>;
+
+		// Returns the register of an identical instruction if there is one, otherwise appends it.
+		int Append(const NoiseInstruction<B, F>& instruction) {
+			const InstructionKey key(
+				instruction.Op,
+				instruction.In[0], instruction.In[1], instruction.In[2],
+				instruction.Params[0].ToRaw(), instruction.Params[1].ToRaw(),
+				instruction.Count, instruction.Node
+			);
+
+			auto it = Emitted.find(key);
+			if (it != Emitted.end()) {
+				return it->second;
+			}
+
+			// Calls depend on the axes of the coordinates their node depends on. 
+			NoiseAxes axes = NoiseAxes::None;
+
+			if (instruction.Op == NoiseOp::Call) {
+				const size_t dimensions = (instruction.In[2] >= 0) ? 3 : 2;
+				const NoiseAxes nodeAxes = instruction.Node->GetAxes(dimensions);
+
+				for (int i = 0; i < 3; ++i) {
+					if (instruction.In[i] >= 0 && HasAnyAxis(nodeAxes, NoiseAxisAt(i))) {
+						axes |= GetAxes(instruction.In[i]);
+					}
+				}
+			}
+			else {
+				for (int input : instruction.In) {
+					if (input >= 0) axes |= GetAxes(input);
+				}
+			}
+
+			Instructions.push_back(instruction);
+			Axes.push_back(axes);
+			const int out = int(Instructions.size()) - 1 + InputCount;
+			Emitted.emplace(key, out);
+			return out;
+		}
+
+		size_t Dimensions;
+		std::vector<NoiseInstruction<B, F>> Instructions;
+		std::vector<NoiseAxes> Axes;	// Per instruction
+		std::map<InstructionKey, int> Emitted;
+	};
+}
+HWY_AFTER_NAMESPACE();
+
+#endif  // include guard
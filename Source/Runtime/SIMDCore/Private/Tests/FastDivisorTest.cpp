@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "hwy/highway.h"
+#include "Mathematics/IndexingSIMD.h"
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+HWY_BEFORE_NAMESPACE();
+namespace SIMD::HWY_NAMESPACE
+{
+	// Divides the numerators by the divisor a vector at a time, and compares the quotients and
+	// remainders to / and %. Adds the number of mismatches to mismatches, and logs the first few.
+	static void CheckFastDivisor(
+		FAutomationTestBase& test, int divisor, const std::vector<int32_t>& numerators,
+		int& mismatches
+	) {
+		const hn::ScalableTag<int32_t> d;
+		const int laneCount = hn::Lanes(d);
+		const FastDivisor fastDivisor(divisor);
+
+		std::vector<int32_t> lanes(laneCount);
+		std::vector<int32_t> quotients(laneCount);
+		std::vector<int32_t> remainders(laneCount);
+
+		for (size_t i = 0; i < numerators.size(); i += laneCount) {
+			for (int lane = 0; lane < laneCount; ++lane) {
+				lanes[lane] = numerators[std::min(i + lane, numerators.size() - 1)];
+			}
+
+			const auto numerator = hn::LoadU(d, lanes.data());
+			hn::StoreU(Div(numerator, fastDivisor), d, quotients.data());
+			hn::StoreU(Mod(numerator, fastDivisor), d, remainders.data());
+
+			for (int lane = 0; lane < laneCount; ++lane) {
+				if (quotients[lane] == lanes[lane] / divisor &&
+					remainders[lane] == lanes[lane] % divisor) {
+					continue;
+				}
+
+				if (mismatches++ < 10) {
+					test.AddError(FString::Printf(
+						TEXT("%d / %d: got %d remainder %d, expected %d remainder %d"),
+						lanes[lane], divisor, quotients[lane], remainders[lane],
+						lanes[lane] / divisor, lanes[lane] % divisor
+					));
+				}
+			}
+		}
+	}
+}
+HWY_AFTER_NAMESPACE();
+
+// FastDivisor's Div() and Mod() against integer division, over every divisor up to 65536 and
+// the divisors at the edges of the range (powers of two and their neighbours, INT_MAX), with the
+// numerators around multiples of the divisor and random ones.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFastDivisorTest, "SIMDCore.Mathematics.FastDivisor",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter
+)
+
+bool FFastDivisorTest::RunTest(const FString& Parameters)
+{
+	using namespace SIMD::HWY_NAMESPACE;
+
+	std::vector<int32_t> divisors;
+
+	for (int32_t divisor = 1; divisor <= 65536; ++divisor) {
+		divisors.push_back(divisor);
+	}
+
+	for (int shift = 17; shift < 31; ++shift) {
+		divisors.push_back((1 << shift) - 1);
+		divisors.push_back(1 << shift);
+		divisors.push_back((1 << shift) + 1);
+	}
+
+	divisors.push_back(INT_MAX - 1);
+	divisors.push_back(INT_MAX);
+
+	// Fixed seed, so failures can be reproduced.
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<int32_t> anyPositive(0, INT_MAX);
+
+	for (int i = 0; i < 1000; ++i) {
+		divisors.push_back(std::max(anyPositive(random), 1));
+	}
+
+	std::vector<int32_t> numerators;
+	int mismatches = 0;
+
+	for (int32_t divisor : divisors) {
+		numerators.assign({ 0, 1, 2, INT_MAX - 1, INT_MAX });
+
+		// Around the first, a middle and the last multiples of the divisor
+		const int64_t lastMultiple = int64_t(INT_MAX) / divisor;
+
+		for (int64_t multiple : { int64_t(1), int64_t(2), lastMultiple / 2, lastMultiple }) {
+			for (int64_t offset = -1; offset <= 1; ++offset) {
+				const int64_t numerator = multiple * divisor + offset;
+				if (numerator >= 0 && numerator <= INT_MAX) numerators.push_back(numerator);
+			}
+		}
+
+		for (int i = 0; i < 16; ++i) {
+			numerators.push_back(anyPositive(random));
+		}
+
+		CheckFastDivisor(*this, divisor, numerators, mismatches);
+	}
+
+	// Small numerators are what indexing divides the most.
+	numerators.clear();
+	for (int32_t numerator = 0; numerator < (1 << 16); ++numerator) {
+		numerators.push_back(numerator);
+	}
+
+	for (int32_t divisor = 1; divisor <= 1024; ++divisor) {
+		CheckFastDivisor(*this, divisor, numerators, mismatches);
+	}
+
+	TestEqual(TEXT("Mismatches"), mismatches, 0);
+	return true;
+}
+
+#endif
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "HAL/UnrealMemory.h"
 #include "hwy/aligned_allocator.h"
 
 template <typename T>
@@ -14,7 +15,7 @@ public:
 	AlignedArray() : allocationSize(0), numElements(0), data(nullptr) {}
 
 	AlignedArray(int count) : allocationSize(count), numElements(0) {
-		data = hwy::AllocateAligned<T>(count);
+		data = Allocate(count);
 	}
 
 	// *********************************************************************************************
@@ -22,13 +23,13 @@ public:
 
 	// Completely newly allocated array. Previous array is discarded.
 	void Reallocate(int count) {
-		data = hwy::AllocateAligned<T>(count);
+		data = Allocate(count);
 		allocationSize = count;
 	}
 
 	// Allocates a new array and copies data from the original to the new array. 
 	void Resize(int count) {
-		auto temp = hwy::AllocateAligned<T>(count);
+		auto temp = Allocate(count);
 
 		if (data) {
 			std::memcpy(temp.get(), data.get(), std::min(allocationSize, count) * sizeof(T));
@@ -64,6 +65,10 @@ public:
 		return data.get();
 	}
 
+	const T* GetPtr() const {
+		return data.get();
+	}
+
 	int GetSize() const {
 		return allocationSize;
 	}
@@ -112,6 +117,20 @@ public:
 	// *********************************************************************************************
 	// Data
 private:
+	// Allocates through FMemory rather than malloc, so that arrays are tracked (and seen by
+	// allocator hooks) like the rest of the engine's memory. Highway aligns the block itself.
+	static hwy::AlignedFreeUniquePtr<T[]> Allocate(int count) {
+		return hwy::AllocateAligned<T>(count, &AllocateBytes, &FreeBytes, nullptr);
+	}
+
+	static void* AllocateBytes(void* opaque, size_t bytes) {
+		return FMemory::Malloc(bytes);
+	}
+
+	static void FreeBytes(void* opaque, void* memory) {
+		FMemory::Free(memory);
+	}
+
 	int allocationSize;
 	int numElements;
 	hwy::AlignedFreeUniquePtr<T[]> data;
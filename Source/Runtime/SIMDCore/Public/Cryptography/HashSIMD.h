@@ -80,6 +80,28 @@ namespace SIMD::HWY_NAMESPACE
         ))));
         return Scramble(h);
     }
+
+    // Multipliers of Hash()'s inputs, by input count then input index.
+    inline constexpr uint64_t HashMultipliers[5][5] = {
+        { 0x5D588B656C078965 },
+        { 0x517CC1B727220A95, 0x54D2B4FC190DCD52 },
+        { 0x5D588B656C078965, 0x6C5A13E6B79C54C3, 0x7D5A9B6F1550D39F },
+        { 0x7F4A7C15F8D5C67B, 0x6D1CE4E5B9BF5847, 0x5D588B656C078965, 0x9E3779B97F4A7C15 },
+        {
+            0x8D2D7D6B7F3B2F81, 0x9E3779B97F4A7C15, 0x5D588B656C078965, 0x6C5A13E6B79C54C3,
+            0x7F4A7C15F8D5C67B
+        }
+    };
+
+    // Term of Hash()'s Index-th input, out of Count inputs. Hash() scrambles the sum of its
+    // inputs' terms, so hashes of points that share coordinates (e.g. the corners of a grid cell)
+    // can compute each coordinate's term once, then only add and scramble per point:
+    // Hash(a, b, c) == Scramble(HashTerm<3, 0>(a) + HashTerm<3, 1>(b) + HashTerm<3, 2>(c))
+    template <size_t Count, size_t Index, class V> requires std::is_unsigned_v<hn::TFromV<V>>
+    HWY_INLINE constexpr V HashTerm(V a) {
+        static_assert(Count >= 1 && Count <= 5 && Index < Count, "Hash() has 1 to 5 inputs");
+        return Mul(a, HashMultipliers[Count - 1][Index]);
+    }
 }
 HWY_AFTER_NAMESPACE();
 
@@ -11,10 +11,58 @@
 #include "hwy/highway.h"
 #include "OperationsSIMD.h"
 #include "Mathematics/Indexing.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
 
 HWY_BEFORE_NAMESPACE();
 namespace SIMD::HWY_NAMESPACE
 {
+	// Precomputed division by a loop-invariant divisor, such as a grid size. Divides with a 
+	// multiply-high and two shifts rather than an integer division, which most targets emulate
+	// lane by lane. See Granlund & Montgomery, "Division by Invariant Integers using 
+	// Multiplication" (Figure 4.1). 
+	//
+	// Exact for every dividend in [0, INT_MAX] and divisor in [1, INT_MAX]. Negative dividends 
+	// are not supported (indices never are). 
+	struct FastDivisor
+	{
+		explicit FastDivisor(int divisor) : Divisor(divisor) {
+			assert(divisor > 0);
+
+			// l = ceil(log2(divisor))
+			const int l = std::bit_width(static_cast<uint32_t>(divisor - 1));
+			Multiplier = static_cast<uint32_t>(
+				((uint64_t(1) << 32) * ((uint64_t(1) << l) - divisor)) / divisor + 1);
+			Shift1 = std::min(l, 1);
+			Shift2 = std::max(l - 1, 0);
+		}
+
+		int Divisor;
+		uint32_t Multiplier;
+		int Shift1;
+		int Shift2;
+	};
+
+	template <class V>
+	HWY_INLINE V Div(V a, const FastDivisor& b) {
+		const hn::DFromV<V> d;
+		const hn::RebindToUnsigned<decltype(d)> du;
+
+		// q = (t + ((a - t) >> s1)) >> s2, where t = mulhi(a, m)
+		const auto ua = hn::BitCast(du, a);
+		const auto t = hn::MulHigh(ua, hn::Set(du, b.Multiplier));
+		const auto q = hn::ShiftRightSame(
+			hn::Add(t, hn::ShiftRightSame(hn::Sub(ua, t), b.Shift1)), b.Shift2);
+		return hn::BitCast(d, q);
+	}
+
+	template <class V>
+	HWY_INLINE V Mod(V a, const FastDivisor& b) {
+		return sn::Sub(a, sn::Mul(sn::Div(a, b), b.Divisor));
+	}
+
 	// Uses vector math to create index vectors for the consecutive indices
 	// Ordering follows the order from GameCore Indexing.h
 	//
@@ -46,7 +94,8 @@ namespace SIMD::HWY_NAMESPACE
 	//
 	template <class V>
 	HWY_INLINE void VUnravel(
-		int startX, int startY, int startZ, int sizeX, int sizeY, int sizeZ,
+		int startX, int startY, int startZ, 
+		const FastDivisor& sizeX, const FastDivisor& sizeY, const FastDivisor& sizeZ,
 		V& x, V& y, V& z
 	) {
 		const hn::DFromV<V> d;
@@ -63,18 +112,37 @@ namespace SIMD::HWY_NAMESPACE
 
 	template <class V>
 	HWY_INLINE void VUnravel(
-		int i, int sizeX, int sizeY, int sizeZ,
+		int startX, int startY, int startZ, int sizeX, int sizeY, int sizeZ,
+		V& x, V& y, V& z
+	) {
+		VUnravel(
+			startX, startY, startZ, FastDivisor(sizeX), FastDivisor(sizeY), FastDivisor(sizeZ),
+			x, y, z
+		);
+	}
+
+	template <class V>
+	HWY_INLINE void VUnravel(
+		int i, const FastDivisor& sizeX, const FastDivisor& sizeY, const FastDivisor& sizeZ,
 		V& x, V& y, V& z
 	) {
 		int startX, startY, startZ;
-		Unravel(i, sizeX, sizeY, startX, startY, startZ);
+		Unravel(i, sizeX.Divisor, sizeY.Divisor, startX, startY, startZ);
 		VUnravel(startX, startY, startZ, sizeX, sizeY, sizeZ, x, y, z);
 	}
 
+	template <class V>
+	HWY_INLINE void VUnravel(
+		int i, int sizeX, int sizeY, int sizeZ,
+		V& x, V& y, V& z
+	) {
+		VUnravel(i, FastDivisor(sizeX), FastDivisor(sizeY), FastDivisor(sizeZ), x, y, z);
+	}
+
 	// See 3D version for implementation detail.s
 	template <class V>
 	HWY_INLINE void VUnravel(
-		int startX, int startY, int sizeX, int sizeY, V& x, V& y
+		int startX, int startY, const FastDivisor& sizeX, const FastDivisor& sizeY, V& x, V& y
 	) {
 		const hn::DFromV<V> d;
 
@@ -86,12 +154,26 @@ namespace SIMD::HWY_NAMESPACE
 	}
 
 	template <class V>
-	HWY_INLINE void VUnravel(int i, int sizeX, int sizeY, V& x, V& y) {
+	HWY_INLINE void VUnravel(
+		int startX, int startY, int sizeX, int sizeY, V& x, V& y
+	) {
+		VUnravel(startX, startY, FastDivisor(sizeX), FastDivisor(sizeY), x, y);
+	}
+
+	template <class V>
+	HWY_INLINE void VUnravel(
+		int i, const FastDivisor& sizeX, const FastDivisor& sizeY, V& x, V& y
+	) {
 		int startX, startY;
-		Unravel(i, sizeX, startX, startY);
+		Unravel(i, sizeX.Divisor, startX, startY);
 		VUnravel(startX, startY, sizeX, sizeY, x, y);
 	}
 
+	template <class V>
+	HWY_INLINE void VUnravel(int i, int sizeX, int sizeY, V& x, V& y) {
+		VUnravel(i, FastDivisor(sizeX), FastDivisor(sizeY), x, y);
+	}
+
 	template <class V>
 	HWY_INLINE V VFlatten(V x, V y, int sizeX) {
 		return sn::Add(sn::Mul(y, sizeX), x);
@@ -9,6 +9,9 @@
 #endif
 
 #include "hwy/highway.h"
+#include "StoreMode.h"
+#include <algorithm>
+#include <type_traits>
 
 HWY_BEFORE_NAMESPACE();
 namespace SIMD::HWY_NAMESPACE
@@ -97,35 +100,175 @@ HWY_INLINE V OpName(Number1 x, Number2 a, Number3 b) {											\
 	}
 
 	// *********************************************************************************************
-	// Demote/Promote with Memory
-	template <typename TIn, typename TOut>
-	HWY_INLINE void Store(hn::Vec<hn::ScalableTag<TIn>> val, TOut* HWY_RESTRICT array) {
-		using id = hn::ScalableTag<TIn>;
-		using ivec = hn::Vec<id>;
+	// Conversion with Memory
+	//
+	// Stores the lanes of an integer vector as TOut, scaled by 2^Shift. Every integer output 
+	// (narrower, as wide, or wider than TIn) as well as float and half are supported. 
+	// Integer outputs are rounded and clamped according to Mode. Float outputs are rounded to 
+	// nearest, and always in range. 
+
+	// Scales integer lanes by 2^Shift, with the rounding and clamping of Mode for TOut. 
+	// Lanes that are wider than TOut are clamped (or wrapped) later, when they are narrowed. 
+	template <typename TOut, StoreMode Mode, int Shift, class V>
+	HWY_INLINE V ScaleForStore(V v) {
+		using TW = hn::TFromV<V>;
+		const hn::DFromV<V> d;
+		static_assert(Shift < int(sizeof(TOut) * 8), "Every value would overflow");
 
-		// Needs to demote TIn to TOut
-		if constexpr (sizeof(TOut) < sizeof(TIn)) {
-			using od = hn::Rebind<TOut, id>;
-			using ovec = hn::Vec<od>;
+		if constexpr (Shift < 0) {
+			if constexpr (Mode == StoreMode::Round) {
+				v = hn::Add(v, hn::Set(d, TW(TW(1) << (-Shift - 1))));
+			}
+
+			v = hn::ShiftRight<-Shift>(v);
+		}
+		else if constexpr (Shift > 0 && Mode == StoreMode::Truncate) {
+			v = hn::ShiftLeft<Shift>(v);
+		}
+		else if constexpr (Shift > 0) {
+			// Compared before shifting, since the shift itself overflows. 
+			const auto over = hn::Gt(v, hn::Set(d, TW(hwy::LimitsMax<TOut>() >> Shift)));
+			const auto under = hn::Lt(v, hn::Set(d, TW(hwy::LimitsMin<TOut>() >> Shift)));
+			v = hn::ShiftLeft<Shift>(v);
+			v = hn::IfThenElse(over, hn::Set(d, TW(hwy::LimitsMax<TOut>())), v);
+			v = hn::IfThenElse(under, hn::Set(d, TW(hwy::LimitsMin<TOut>())), v);
+		}
 
-			ovec outval = hn::DemoteTo(od(), val);
-			hn::StoreN(outval, od(), array, hn::Lanes(id()));
+		// Lanes as wide as TOut aren't narrowed, so they are clamped here. 
+		if constexpr (Shift <= 0 && Mode != StoreMode::Truncate && 
+			sizeof(TOut) == sizeof(TW) && hwy::IsSigned<TW>() && !hwy::IsSigned<TOut>()) {
+			v = hn::Max(v, hn::Zero(d));
 		}
-		// No promote needed
-		// Current implementation is to just use the bits rather than make destructive changes
-		else if constexpr (sizeof(TOut) == sizeof(TIn)) {
-			using od = hn::ScalableTag<TOut>;
-			using ovec = hn::Vec<od>;
 
-			ovec outval = Reinterpret<ovec>(val);
-			hn::Store(outval, od(), array);
+		return v;
+	}
+
+	// Writes the first count lanes of v. Non-temporal if IsStream and v is a whole vector, in 
+	// which case array must be aligned. 
+	template <bool IsStream, class D>
+	HWY_INLINE void StoreOrStream(
+		hn::VFromD<D> v, D d, hn::TFromD<D>* HWY_RESTRICT array, size_t count
+	) {
+		if (count < hn::Lanes(d)) {
+			hn::StoreN(v, d, array, count);
+		}
+		else if constexpr (IsStream) {
+			hn::Stream(v, d, array);
 		}
-		// Needs to promote TIn to TOut
 		else {
+			hn::StoreU(v, d, array);
+		}
+	}
 
+	// Writes the first count lanes of v, scaled by ScaleForStore(), as TOut. 
+	template <typename TOut, StoreMode Mode, bool IsStream, class V>
+	HWY_INLINE void StoreIntegerLanes(V v, TOut* HWY_RESTRICT array, size_t count) {
+		using TW = hn::TFromV<V>;
+		const hn::DFromV<V> d;
+
+		if constexpr (sizeof(TOut) == sizeof(TW)) {
+			const hn::Rebind<TOut, decltype(d)> od;
+			StoreOrStream<IsStream>(hn::BitCast(od, v), od, array, count);
+		}
+		else if constexpr (Mode == StoreMode::Truncate) {
+			// Keeps the low bits
+			using TU = hwy::MakeUnsigned<TOut>;
+			const hn::RebindToUnsigned<decltype(d)> du;
+			const hn::Rebind<TU, decltype(d)> od;
+			StoreOrStream<false>(
+				hn::TruncateTo(od, hn::BitCast(du, v)), od, reinterpret_cast<TU*>(array), count);
+		}
+		else {
+			// Clamps to TOut
+			const hn::Rebind<TOut, decltype(d)> od;
+			StoreOrStream<false>(hn::DemoteTo(od, v), od, array, count);
+		}
+	}
+
+	// Writes the first count lanes of v, scaled by 2^Shift, as float or half. 
+	template <typename TOut, int Shift, bool IsStream, class V>
+	HWY_INLINE void StoreFloatLanes(V v, TOut* HWY_RESTRICT array, size_t count) {
+		using TW = hn::TFromV<V>;
+		const hn::DFromV<V> d;
+		const hn::Rebind<float, decltype(d)> df;
+
+		// Powers of two are exact, so scaling after the conversion doesn't round twice.
+		constexpr double scale = (Shift >= 0) ? 
+			double(uint64_t(1) << Shift) : 1.0 / double(uint64_t(1) << -Shift);
+
+		auto ToFloatLambda = [&]() HWY_ATTR {
+			if constexpr (sizeof(TW) == sizeof(float)) {
+				return hn::Mul(hn::ConvertTo(df, v), hn::Set(df, float(scale)));
+			}
+			else {
+				const hn::Rebind<double, decltype(d)> dd;
+				return hn::DemoteTo(df, hn::Mul(hn::ConvertTo(dd, v), hn::Set(dd, scale)));
+			}
+		};
+
+		if constexpr (hwy::IsSame<TOut, float>()) {
+			StoreOrStream<IsStream && sizeof(TW) == sizeof(float)>(
+				ToFloatLambda(), df, array, count);
+		}
+		else {
+			const hn::Rebind<hwy::float16_t, decltype(df)> dh;
+			StoreOrStream<false>(hn::DemoteTo(dh, ToFloatLambda()), dh, array, count);
 		}
 	}
 
+	// Converts the first count lanes of val to TOut, scaled by 2^Shift, and writes them to array.
+	// Use Shift to convert fixed point values (e.g. -F to get the real value as float). 
+	template <
+		typename TIn, typename TOut, 
+		StoreMode Mode = StoreMode::Saturate, int Shift = 0, bool IsStream = false
+	>
+	HWY_INLINE void StoreN(
+		hn::Vec<hn::ScalableTag<TIn>> val, TOut* HWY_RESTRICT array, size_t count
+	) {
+		using id = hn::ScalableTag<TIn>;
+
+		if constexpr (hwy::IsFloat<TOut>()) {
+			StoreFloatLanes<TOut, Shift, IsStream>(val, array, count);
+		}
+		else if constexpr (sizeof(TOut) <= sizeof(TIn)) {
+			StoreIntegerLanes<TOut, Mode, IsStream>(
+				ScaleForStore<TOut, Mode, Shift>(val), array, count);
+		}
+		else {
+			// Needs to promote TIn to TOut. Promotion takes a fraction of a vector, so the lanes
+			// go through memory, and are widened and written a whole TOut vector at a time. 
+			using TW = std::conditional_t<hwy::IsSigned<TIn>(), 
+				hwy::SignedFromSize<sizeof(TOut)>, hwy::UnsignedFromSize<sizeof(TOut)>>;
+			const hn::ScalableTag<TW> dw;
+			const hn::Rebind<TIn, decltype(dw)> dn;
+
+			HWY_ALIGN TIn lanes[hn::MaxLanes(id())];
+			hn::Store(val, id(), lanes);
+
+			for (size_t i = 0; i < count; i += hn::Lanes(dw)) {
+				const auto wide = hn::PromoteTo(dw, hn::LoadU(dn, lanes + i));
+				StoreIntegerLanes<TOut, Mode, IsStream>(
+					ScaleForStore<TOut, Mode, Shift>(wide), array + i, 
+					std::min(hn::Lanes(dw), count - i)
+				);
+			}
+		}
+	}
+
+	// Same as StoreN, but writes every lane of val. 
+	template <typename TIn, typename TOut, StoreMode Mode = StoreMode::Saturate, int Shift = 0>
+	HWY_INLINE void Store(hn::Vec<hn::ScalableTag<TIn>> val, TOut* HWY_RESTRICT array) {
+		StoreN<TIn, TOut, Mode, Shift>(val, array, hn::Lanes(hn::ScalableTag<TIn>()));
+	}
+
+	// Same as Store, but with non-temporal stores where TOut is as wide as TIn or wider, so that
+	// outputs larger than the cache don't evict it. array must be vector-aligned. 
+	// Call hwy::FlushStream() once done, before other threads read the array. 
+	template <typename TIn, typename TOut, StoreMode Mode = StoreMode::Saturate, int Shift = 0>
+	HWY_INLINE void StoreStream(hn::Vec<hn::ScalableTag<TIn>> val, TOut* HWY_RESTRICT array) {
+		StoreN<TIn, TOut, Mode, Shift, true>(val, array, hn::Lanes(hn::ScalableTag<TIn>()));
+	}
+
 	// *********************************************************************************************
 	// Bitwise
 
@@ -189,6 +332,48 @@ HWY_INLINE V OpName(Number1 x, Number2 a, Number3 b) {											\
 	DEFINE_SCALAR_OP_2(Max);
 	DEFINE_SCALAR_OP_2(Min);
 
+	// *********************************************************************************************
+	// Table Lookups
+
+	// Same as hn::GatherIndex(d, table, idx) for a small table of Size lanes, with every index in
+	// [0, Size). Tables that fit in a few vectors are looked up in registers, 2 vectors at a time,
+	// since gathers are slow (AVX2) or emulated (SSE4, NEON).
+	template <size_t Size, class D>
+	HWY_INLINE hn::VFromD<D> TableLookup(
+		D d, const hn::TFromD<D>* HWY_RESTRICT table, hn::VFromD<hn::RebindToSigned<D>> idx
+	) {
+#if HWY_HAVE_SCALABLE || HWY_TARGET == HWY_SCALAR
+		return hn::GatherIndex(d, table, idx);
+#else
+		using TI = hn::TFromV<decltype(idx)>;
+		constexpr size_t N = hn::MaxLanes(d);
+		const hn::RebindToSigned<D> di;
+
+		if constexpr (Size <= N) {
+			return hn::TableLookupLanes(hn::LoadN(d, table, Size), hn::IndicesFromVec(d, idx));
+		}
+		else {
+			constexpr size_t Chunk = 2 * N;
+			const auto chunkIdx = hn::IndicesFromVec(d, hn::And(idx, hn::Set(di, TI(Chunk - 1))));
+
+			hn::VFromD<D> result = hn::Zero(d);
+			for (size_t offset = 0; offset < Size; offset += Chunk) {
+				const size_t upperCount = (Size > offset + N) ? std::min(N, Size - offset - N) : 0;
+				const hn::VFromD<D> lookup = hn::TwoTablesLookupLanes(d,
+					hn::LoadN(d, table + offset, std::min(N, Size - offset)),
+					hn::LoadN(d, table + offset + N, upperCount),
+					chunkIdx
+				);
+
+				result = (offset == 0) ? lookup : hn::IfThenElse(
+					hn::RebindMask(d, hn::Ge(idx, hn::Set(di, TI(offset)))), lookup, result);
+			}
+
+			return result;
+		}
+#endif
+	}
+
 	
 	// *********************************************************************************************
 	// Reductions
@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+
+namespace SIMD
+{
+	// How SIMD::Store() converts values into an integer output type.
+	enum class StoreMode : uint8_t
+	{
+		Saturate,	// Rounds down, and clamps values that don't fit the output
+		Round,		// Rounds to nearest, and clamps values that don't fit the output
+		Truncate	// Rounds down, and keeps the low bits of values that don't fit the output
+	};
+}